@@ -0,0 +1,82 @@
+#!/bin/bash
+# clean-build time of a synthetic project whose translation units each
+# format a few values, once with #include "format.hpp" and once with
+# import lrstd.format. the import build needs what the module does: CMake
+# 3.28, Ninja and a compiler the module supports (see CMakeLists.txt).
+#
+#     bench/module_build.sh [work dir] [translation units] [modes]
+#
+# modes is "include import" by default; pass one of them to build only that.
+
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=${1:-module_build}
+count=${2:-500}
+modes=${3:-include import}
+
+generate() {
+    local mode=$1 target=$2 dir=$work/$1
+    rm -rf "$dir"
+    mkdir -p "$dir/src"
+    local version=3.14
+    if [ "$mode" = import ]; then
+        version=3.28
+    fi
+    cat > "$dir/CMakeLists.txt" <<EOF
+cmake_minimum_required(VERSION $version)
+project(module_build_$mode CXX)
+add_subdirectory($root format)
+file(GLOB sources src/*.cpp)
+add_library(app STATIC \${sources})
+target_link_libraries(app PRIVATE $target)
+target_compile_features(app PRIVATE cxx_std_20)
+EOF
+    for ((i = 0; i < count; ++i)); do
+        {
+            if [ "$mode" = include ]; then
+                echo '#include "format.hpp"'
+                echo
+                echo '#include <iterator>'
+                echo '#include <string>'
+                echo '#include <string_view>'
+            else
+                echo '#include <iterator>'
+                echo '#include <string>'
+                echo '#include <string_view>'
+                echo
+                echo 'import lrstd.format;'
+            fi
+            cat <<EOF
+
+std::string tu_$i(int n, std::string_view name) {
+    std::string s = lrstd::format("{}: {:>8} {:#x}", name, n, $i);
+    lrstd::format_to(std::back_inserter(s), " {:*^6}", n % 2 == 0);
+    return s;
+}
+EOF
+        } > "$dir/src/tu_$i.cpp"
+    done
+}
+
+build() {
+    local dir=$work/$1 options=()
+    if [ "$1" = import ]; then
+        options=(-G Ninja -DFORMAT_BUILD_MODULE=ON)
+    fi
+    cmake -S "$dir" -B "$dir/build" -DCMAKE_BUILD_TYPE=Release \
+          "${options[@]}" > /dev/null
+    local start=$(date +%s%N)
+    cmake --build "$dir/build" --parallel > /dev/null
+    local end=$(date +%s%N)
+    echo "$1: $(((end - start) / 1000000)) ms for $count translation units"
+}
+
+for mode in $modes; do
+    if [ "$mode" = include ]; then
+        generate include format
+    else
+        generate import format_module
+    fi
+    build "$mode"
+done
@@ -0,0 +1,57 @@
+// writes the same lines to /dev/null with printf, iostreams and lrstd::print,
+// and reports the time each one takes.
+#include "print.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+constexpr int iterations = 1000000;
+
+template <class F>
+void run(const char* name, F f) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        f(i);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": "
+              << std::chrono::duration<double, std::milli>(elapsed).count()
+              << " ms\n";
+}
+}  // namespace
+
+int main() {
+    std::FILE* const file = std::fopen("/dev/null", "w");
+    const int fd = ::open("/dev/null", O_WRONLY);
+    std::ofstream stream("/dev/null");
+    if (!file || fd < 0 || !stream) {
+        std::cerr << "can't open /dev/null\n";
+        return 1;
+    }
+
+    run("fprintf", [&](int i) {
+        std::fprintf(file, "%s %d: %08x %-6s|\n", "line", i,
+                     static_cast<unsigned>(i), "end");
+    });
+    run("ofstream", [&](int i) {
+        stream << "line " << i << ": " << std::hex << std::setw(8)
+               << std::setfill('0') << i << std::dec << ' '
+               << std::setfill(' ') << std::left << std::setw(6) << "end"
+               << std::right << "|\n";
+    });
+    run("lrstd::println(FILE*)", [&](int i) {
+        lrstd::println(file, "{} {}: {:08x} {:<6}|", "line", i, i, "end");
+    });
+    run("lrstd::println(fd)", [&](int i) {
+        lrstd::println(fd, "{} {}: {:08x} {:<6}|", "line", i, i, "end");
+    });
+
+    std::fclose(file);
+    ::close(fd);
+}
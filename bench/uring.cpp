@@ -0,0 +1,65 @@
+// writes the same lines to a file with fprintf, print(fd), and the
+// uring_file_sink with and without io_uring, and reports the time each one
+// takes. run it once with a path on tmpfs and once with a path on disk:
+//
+//     format_bench_uring /dev/shm/bench.txt ./bench.txt
+#include "uring_file_sink.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+constexpr int lines = 2000000;
+
+template <class F>
+void run(const char* path, const char* name, F f) {
+    const auto start = std::chrono::steady_clock::now();
+    f(path);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << path << ": " << name << ": "
+              << std::chrono::duration<double, std::milli>(elapsed).count()
+              << " ms\n";
+    std::remove(path);
+}
+
+void bench(const char* path) {
+    run(path, "fprintf", [](const char* p) {
+        std::FILE* const file = std::fopen(p, "w");
+        for (int i = 0; i < lines; ++i)
+            std::fprintf(file, "%s %d: %08x %-6s|\n", "line", i,
+                         static_cast<unsigned>(i), "end");
+        std::fclose(file);
+    });
+    run(path, "lrstd::println(fd)", [](const char* p) {
+        const int fd = ::open(p, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        for (int i = 0; i < lines; ++i)
+            lrstd::println(fd, "{} {}: {:08x} {:<6}|", "line", i, i, "end");
+        ::close(fd);
+    });
+    for (const bool use_pwrite : {true, false}) {
+        lrstd::uring_file_options options;
+        options.use_pwrite = use_pwrite;
+        run(path, use_pwrite ? "uring_file_sink (pwrite)" : "uring_file_sink",
+            [&](const char* p) {
+                lrstd::uring_file_sink sink(p, options);
+                for (int i = 0; i < lines; ++i)
+                    lrstd::format_to(sink.out(), "{} {}: {:08x} {:<6}|\n",
+                                     "line", i, i, "end");
+                sink.close();
+            });
+    }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " path...\n";
+        return 1;
+    }
+    for (int i = 1; i < argc; ++i)
+        bench(argv[i]);
+}
@@ -0,0 +1,70 @@
+#ifndef LRSTD_FORMAT_ARENA_HPP
+#define LRSTD_FORMAT_ARENA_HPP
+
+#include "_common.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace lrstd::detail {
+
+// bump allocator handing out memory from a list of chunks. clear() rewinds to
+// the first chunk but keeps every chunk alive, so an arena that is reused for
+// similarly sized workloads stops allocating once it has warmed up.
+class arena {
+    struct chunk {
+        std::unique_ptr<unsigned char[]> data;
+        std::size_t size;
+    };
+    std::vector<chunk> _chunks;
+    std::size_t _current = 0;
+    std::size_t _offset = 0;
+
+    static constexpr std::size_t min_chunk_size = 256;
+
+    void* try_allocate(const chunk& c,
+                       std::size_t size,
+                       std::size_t align) noexcept {
+        void* p = c.data.get() + _offset;
+        std::size_t space = c.size - _offset;
+        if (!std::align(align, size, p, space))
+            return nullptr;
+        _offset = c.size - space + size;
+        return p;
+    }
+
+   public:
+    arena() noexcept = default;
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t align) {
+        for (; _current < _chunks.size(); ++_current, _offset = 0) {
+            if (void* p = try_allocate(_chunks[_current], size, align))
+                return p;
+        }
+        const std::size_t last_size =
+              _chunks.empty() ? min_chunk_size / 2 : _chunks.back().size;
+        const std::size_t chunk_size = std::max(last_size * 2, size + align);
+        _chunks.push_back(
+              chunk{std::unique_ptr<unsigned char[]>(
+                          new unsigned char[chunk_size]),
+                    chunk_size});
+        _current = _chunks.size() - 1;
+        _offset = 0;
+        void* p = try_allocate(_chunks.back(), size, align);
+        LRSTD_ASSERT(p);
+        return p;
+    }
+
+    void clear() noexcept {
+        _current = 0;
+        _offset = 0;
+    }
+};
+
+}  // namespace lrstd::detail
+
+#endif
@@ -0,0 +1,712 @@
+#ifndef LRSTD_FORMAT_BUFFER_HPP
+#define LRSTD_FORMAT_BUFFER_HPP
+
+#include "_common.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lrstd {
+
+namespace detail {
+
+// contiguous character storage written through a raw pointer. when a write
+// doesn't fit, the buffer calls its grow function, which the concrete buffer
+// implements by reallocating (or, for buffers in front of some other output,
+// by flushing). after grow returns there is room for at least one more
+// character, but not necessarily for everything that was requested.
+template <class CharT>
+class buffer {
+    CharT* _ptr;
+    std::size_t _size;
+    std::size_t _capacity;
+    void (*_grow)(buffer&, std::size_t);
+
+   protected:
+    explicit buffer(void (*grow)(buffer&, std::size_t)) noexcept
+        : _ptr{nullptr}, _size{0}, _capacity{0}, _grow{grow} {}
+    buffer(const buffer&) = delete;
+    buffer& operator=(const buffer&) = delete;
+    ~buffer() = default;
+
+    void set(CharT* ptr, std::size_t capacity) noexcept {
+        _ptr = ptr;
+        _capacity = capacity;
+    }
+
+   public:
+    using value_type = CharT;
+
+    CharT* data() noexcept { return _ptr; }
+    const CharT* data() const noexcept { return _ptr; }
+    std::size_t size() const noexcept { return _size; }
+    std::size_t capacity() const noexcept { return _capacity; }
+
+    void clear() noexcept { _size = 0; }
+
+    // only valid for sizes that are within capacity()
+    void set_size(std::size_t size) noexcept {
+        LRSTD_ASSERT(size <= _capacity);
+        _size = size;
+    }
+
+    void try_reserve(std::size_t capacity) {
+        if (capacity > _capacity)
+            _grow(*this, capacity);
+    }
+
+    void push_back(CharT c) {
+        try_reserve(_size + 1);
+        _ptr[_size++] = c;
+    }
+
+    template <class C>
+    void append(const C* first, const C* last) {
+        while (first != last) {
+            const auto count = static_cast<std::size_t>(last - first);
+            try_reserve(_size + count);
+            const std::size_t n = std::min(count, _capacity - _size);
+            // the source may overlap the output of a pointer_buffer
+            if constexpr (std::is_same_v<C, CharT>)
+                std::char_traits<CharT>::move(_ptr + _size, first, n);
+            else
+                std::copy(first, first + n, _ptr + _size);
+            _size += n;
+            first += n;
+        }
+    }
+
+    void append(std::size_t count, CharT c) {
+        while (count != 0) {
+            try_reserve(_size + count);
+            const std::size_t n = std::min(count, _capacity - _size);
+            std::char_traits<CharT>::assign(_ptr + _size, n, c);
+            _size += n;
+            count -= n;
+        }
+    }
+};
+
+// output iterator appending to a buffer
+template <class CharT>
+class buffer_iter {
+    buffer<CharT>* _buf;
+
+   public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    explicit buffer_iter(buffer<CharT>& buf) noexcept : _buf{&buf} {}
+
+    buffer_iter& operator*() noexcept { return *this; }
+    buffer_iter& operator++() noexcept { return *this; }
+    buffer_iter& operator++(int) noexcept { return *this; }
+
+    buffer_iter& operator=(CharT c) {
+        _buf->push_back(c);
+        return *this;
+    }
+
+    template <class C, class T>
+    buffer_iter& write(std::basic_string_view<C, T> sv) {
+        _buf->append(sv.data(), sv.data() + sv.size());
+        return *this;
+    }
+
+    template <class C>
+    buffer_iter& write(C c, std::size_t count) {
+        _buf->append(count, static_cast<CharT>(c));
+        return *this;
+    }
+
+    buffer<CharT>& container() const noexcept { return *_buf; }
+};
+
+// fixed-size buffer in front of an arbitrary output iterator. whenever it
+// fills up its contents are handed to the iterator in one std::copy.
+template <class Out, class CharT, std::size_t N = 256>
+class iterator_buffer : public buffer<CharT> {
+    Out _out;
+    CharT _data[N];
+
+    static void grow(buffer<CharT>& buf, std::size_t) {
+        static_cast<iterator_buffer&>(buf).flush();
+    }
+
+   public:
+    explicit iterator_buffer(Out out) : buffer<CharT>{&grow}, _out{out} {
+        this->set(_data, N);
+    }
+
+    void flush() {
+        _out = std::copy(_data, _data + this->size(), _out);
+        this->clear();
+    }
+
+    Out out() {
+        flush();
+        return _out;
+    }
+};
+
+// writes straight through a pointer, with no end in sight
+template <class CharT>
+class pointer_buffer : public buffer<CharT> {
+    static void grow(buffer<CharT>&, std::size_t) noexcept {}
+
+   public:
+    explicit pointer_buffer(CharT* out) noexcept : buffer<CharT>{&grow} {
+        this->set(out, std::numeric_limits<std::size_t>::max());
+    }
+};
+
+// the part of a size-limited output that has left its buffer. together
+// with the buffer's size() it says how much was written in total.
+struct output_limit {
+    std::size_t limit;
+    std::size_t count = 0;  // including whatever went past the limit
+
+    // counts n more characters and returns how many of them to keep
+    std::size_t take(std::size_t n) noexcept {
+        const std::size_t room = count < limit ? limit - count : 0;
+        count += n;
+        return std::min(n, room);
+    }
+};
+
+// writes the first limit characters straight through a pointer. the rest
+// go into a scratch area and are only counted.
+template <class CharT, std::size_t N = 256>
+class limited_pointer_buffer : public buffer<CharT> {
+    CharT* _out;
+    output_limit& _limit;
+    CharT _scratch[N];
+
+    // appends fill the output up to the limit before this switches over
+    static void grow(buffer<CharT>& buf, std::size_t) {
+        auto& self = static_cast<limited_pointer_buffer&>(buf);
+        if (self.size() < self.capacity())
+            return;
+        self._limit.take(self.size());
+        self.set(self._scratch, N);
+        self.clear();
+    }
+
+   public:
+    limited_pointer_buffer(CharT* out, output_limit& limit) noexcept
+        : buffer<CharT>{&grow}, _out{out}, _limit{limit} {
+        this->set(out, limit.limit);
+    }
+
+    CharT* out() const noexcept {
+        return _out + std::min(_limit.count + this->size(), _limit.limit);
+    }
+};
+
+// like iterator_buffer, but only the first limit characters reach out; the
+// rest are only counted
+template <class Out, class CharT, std::size_t N = 256>
+class limited_iterator_buffer : public buffer<CharT> {
+    Out _out;
+    output_limit& _limit;
+    CharT _data[N];
+
+    static void grow(buffer<CharT>& buf, std::size_t) {
+        static_cast<limited_iterator_buffer&>(buf).flush();
+    }
+
+   public:
+    limited_iterator_buffer(Out out, output_limit& limit)
+        : buffer<CharT>{&grow}, _out{out}, _limit{limit} {
+        this->set(_data, N);
+    }
+
+    void flush() {
+        _out = std::copy_n(_data, _limit.take(this->size()), _out);
+        this->clear();
+    }
+
+    Out out() {
+        flush();
+        return _out;
+    }
+};
+
+// writes straight into the end of a string. the string is resized to cover
+// the whole capacity up front and trimmed back to what was written by
+// commit(); if commit() is never reached it goes back to its original size.
+template <class String>
+class string_append_buffer : public buffer<typename String::value_type> {
+    using base = buffer<typename String::value_type>;
+
+    String& _str;
+    std::size_t _offset;
+    bool _committed = false;
+
+    static void grow(base& buf, std::size_t capacity) {
+        auto& self = static_cast<string_append_buffer&>(buf);
+        const std::size_t old_capacity = self.capacity();
+        self.resize_to(std::max(capacity, old_capacity + old_capacity / 2));
+    }
+
+    void resize_to(std::size_t capacity) {
+        _str.resize(_offset + capacity);
+        this->set(_str.data() + _offset, capacity);
+    }
+
+   public:
+    string_append_buffer(String& str, std::size_t size_hint)
+        : base{&grow}, _str{str}, _offset{str.size()} {
+        resize_to(size_hint);
+    }
+    ~string_append_buffer() {
+        _str.resize(_offset + (_committed ? this->size() : 0));
+    }
+
+    void commit() noexcept { _committed = true; }
+};
+
+}  // namespace detail
+
+inline constexpr std::size_t inline_buffer_size = 500;
+
+// a growable character buffer that keeps its first InlineN characters in
+// the object itself, so short outputs never touch the heap. anything bigger
+// comes from Alloc.
+template <class CharT,
+          std::size_t InlineN = inline_buffer_size,
+          class Alloc = std::allocator<CharT>>
+class basic_memory_buffer : public detail::buffer<CharT> {
+    using base = detail::buffer<CharT>;
+    using alloc_traits = std::allocator_traits<Alloc>;
+
+    CharT _inline[InlineN];
+    Alloc _alloc;
+
+    static void grow(base& buf, std::size_t capacity) {
+        auto& self = static_cast<basic_memory_buffer&>(buf);
+        const std::size_t old_capacity = self.capacity();
+        const std::size_t new_capacity =
+              std::max(capacity, old_capacity + old_capacity / 2);
+        CharT* const new_data =
+              alloc_traits::allocate(self._alloc, new_capacity);
+        std::char_traits<CharT>::copy(new_data, self.data(), self.size());
+        self.deallocate();
+        self.set(new_data, new_capacity);
+    }
+
+    void deallocate() noexcept {
+        if (this->data() != _inline)
+            alloc_traits::deallocate(_alloc, this->data(), this->capacity());
+    }
+
+   public:
+    using allocator_type = Alloc;
+
+    basic_memory_buffer() noexcept(noexcept(Alloc())) : base{&grow}, _alloc{} {
+        this->set(_inline, InlineN);
+    }
+    explicit basic_memory_buffer(const Alloc& alloc) noexcept
+        : base{&grow}, _alloc{alloc} {
+        this->set(_inline, InlineN);
+    }
+    ~basic_memory_buffer() { deallocate(); }
+
+    Alloc get_allocator() const { return _alloc; }
+
+    void reserve(std::size_t capacity) { this->try_reserve(capacity); }
+    void resize(std::size_t size) {
+        this->try_reserve(size);
+        this->set_size(size);
+    }
+
+    // gives back whatever storage is beyond max(capacity, size())
+    void shrink_to(std::size_t capacity) {
+        capacity = std::max(capacity, this->size());
+        if (this->data() == _inline || this->capacity() <= capacity)
+            return;
+        CharT* new_data = _inline;
+        if (capacity > InlineN)
+            new_data = alloc_traits::allocate(_alloc, capacity);
+        else
+            capacity = InlineN;
+        std::char_traits<CharT>::copy(new_data, this->data(), this->size());
+        deallocate();
+        this->set(new_data, capacity);
+    }
+};
+
+using memory_buffer = basic_memory_buffer<char>;
+using wmemory_buffer = basic_memory_buffer<wchar_t>;
+
+namespace detail {
+
+// output for a scatter-gather write. characters written to it are copied
+// into side storage, but text that is known to outlive the format call (see
+// stable_text_scope) is only referred to, once it is at least borrow_min
+// characters long. for_each_span visits both kinds in output order.
+template <class CharT>
+class scatter_buffer {
+    struct span {
+        const CharT* borrowed;  // null for a run of the side storage
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    basic_memory_buffer<CharT> _side;
+    std::vector<span> _spans;
+    std::size_t _run_start = 0;
+    std::size_t _borrow_min;
+    bool _stable = false;
+
+    void end_run() {
+        if (_side.size() != _run_start) {
+            _spans.push_back({nullptr, _run_start, _side.size() - _run_start});
+            _run_start = _side.size();
+        }
+    }
+
+   public:
+    explicit scatter_buffer(std::size_t borrow_min) noexcept
+        : _borrow_min{borrow_min} {}
+
+    buffer<CharT>& side() noexcept { return _side; }
+
+    // returns the previous setting
+    bool set_stable(bool stable) noexcept {
+        const bool old = _stable;
+        _stable = stable;
+        return old;
+    }
+
+    void append_stable(const CharT* data, std::size_t size) {
+        if (!_stable || size < _borrow_min || size == 0)
+            return _side.append(data, data + size);
+        end_run();
+        if (!_spans.empty()) {
+            span& last = _spans.back();
+            if (last.borrowed && last.borrowed + last.size == data) {
+                last.size += size;
+                return;
+            }
+        }
+        _spans.push_back({data, 0, size});
+    }
+
+    template <class F>
+    void for_each_span(F f) {
+        end_run();
+        for (const span& s : _spans)
+            f(s.borrowed ? s.borrowed : _side.data() + s.offset, s.size);
+    }
+
+    void clear() noexcept {
+        _side.clear();
+        _spans.clear();
+        _run_start = 0;
+    }
+};
+
+// writes into a caller's chunk of memory. output that doesn't fit in the
+// chunk goes into an overflow buffer, to be handed out at the start of the
+// next chunk.
+template <class CharT>
+class chunk_buffer : public buffer<CharT> {
+    basic_memory_buffer<CharT> _overflow;
+    std::size_t _overflow_pos = 0;
+    std::size_t _chunk_size = 0;
+    bool _overflowing = false;
+
+    static void grow(buffer<CharT>& buf, std::size_t capacity) {
+        auto& self = static_cast<chunk_buffer&>(buf);
+        // appends fill what's left of the chunk before asking again
+        if (self.size() < self.capacity())
+            return;
+        if (!self._overflowing) {
+            self._overflowing = true;
+            self._chunk_size = self.size();
+            self._overflow.clear();
+            self.set(self._overflow.data(), self._overflow.capacity());
+            self.set_size(0);
+            return;
+        }
+        self._overflow.resize(self.size());
+        self._overflow.reserve(capacity);
+        self.set(self._overflow.data(), self._overflow.capacity());
+    }
+
+   public:
+    chunk_buffer() noexcept : buffer<CharT>{&grow} {}
+
+    bool overflowing() const noexcept { return _overflowing; }
+    bool has_pending() const noexcept {
+        return _overflow_pos != _overflow.size();
+    }
+    std::size_t pending() const noexcept {
+        return _overflow.size() - _overflow_pos;
+    }
+
+    // copies as much of the overflow from earlier chunks as fits into
+    // [first, first + n) and returns how much that was
+    std::size_t take_pending(CharT* first, std::size_t n) noexcept {
+        n = std::min(n, _overflow.size() - _overflow_pos);
+        std::char_traits<CharT>::copy(first, _overflow.data() + _overflow_pos,
+                                      n);
+        _overflow_pos += n;
+        return n;
+    }
+
+    void start_chunk(CharT* first, std::size_t n) noexcept {
+        LRSTD_ASSERT(!has_pending());
+        _overflowing = false;
+        this->set(first, n);
+        this->clear();
+    }
+
+    // returns how much of the chunk was written
+    std::size_t end_chunk() noexcept {
+        if (!_overflowing)
+            return this->size();
+        _overflow.set_size(this->size());
+        _overflow_pos = 0;
+        return _chunk_size;
+    }
+};
+
+// output iterator appending to a scatter_buffer
+template <class CharT>
+class scatter_iter {
+    scatter_buffer<CharT>* _buf;
+
+   public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    explicit scatter_iter(scatter_buffer<CharT>& buf) noexcept : _buf{&buf} {}
+
+    scatter_iter& operator*() noexcept { return *this; }
+    scatter_iter& operator++() noexcept { return *this; }
+    scatter_iter& operator++(int) noexcept { return *this; }
+
+    scatter_iter& operator=(CharT c) {
+        _buf->side().push_back(c);
+        return *this;
+    }
+
+    template <class C, class T>
+    scatter_iter& write(std::basic_string_view<C, T> sv) {
+        _buf->side().append(sv.data(), sv.data() + sv.size());
+        return *this;
+    }
+
+    template <class C>
+    scatter_iter& write(C c, std::size_t count) {
+        _buf->side().append(count, static_cast<CharT>(c));
+        return *this;
+    }
+
+    template <class T>
+    scatter_iter& write_stable(std::basic_string_view<CharT, T> sv) {
+        _buf->append_stable(sv.data(), sv.size());
+        return *this;
+    }
+
+    scatter_buffer<CharT>& container() const noexcept { return *_buf; }
+};
+
+// fixed-size buffer in front of a callback taking string_views. it's
+// handed to the callback whenever it fills up; stable text (see
+// stable_text_scope) of at least borrow_min characters is passed to the
+// callback directly instead of going through the buffer.
+template <class CharT>
+class stream_buffer : public buffer<CharT> {
+    void (*_emit)(void*, std::basic_string_view<CharT>);
+    void* _callback;
+    std::size_t _borrow_min;
+    bool _stable = false;
+
+    // appends fill the buffer up before it is flushed
+    static void grow(buffer<CharT>& buf, std::size_t) {
+        if (buf.size() == buf.capacity())
+            static_cast<stream_buffer&>(buf).flush();
+    }
+
+   protected:
+    stream_buffer(void (*emit)(void*, std::basic_string_view<CharT>),
+                  void* callback,
+                  std::size_t borrow_min) noexcept
+        : buffer<CharT>{&grow}
+        , _emit{emit}
+        , _callback{callback}
+        , _borrow_min{borrow_min} {}
+
+   public:
+    void flush() {
+        if (this->size() != 0) {
+            _emit(_callback, {this->data(), this->size()});
+            this->clear();
+        }
+    }
+
+    // returns the previous setting
+    bool set_stable(bool stable) noexcept {
+        const bool old = _stable;
+        _stable = stable;
+        return old;
+    }
+
+    void append_stable(const CharT* data, std::size_t size) {
+        if (!_stable || size < _borrow_min)
+            return this->append(data, data + size);
+        flush();
+        _emit(_callback, {data, size});
+    }
+};
+
+// output iterator appending to a stream_buffer
+template <class CharT>
+class stream_iter {
+    stream_buffer<CharT>* _buf;
+
+   public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    explicit stream_iter(stream_buffer<CharT>& buf) noexcept : _buf{&buf} {}
+
+    stream_iter& operator*() noexcept { return *this; }
+    stream_iter& operator++() noexcept { return *this; }
+    stream_iter& operator++(int) noexcept { return *this; }
+
+    stream_iter& operator=(CharT c) {
+        _buf->push_back(c);
+        return *this;
+    }
+
+    template <class C, class T>
+    stream_iter& write(std::basic_string_view<C, T> sv) {
+        _buf->append(sv.data(), sv.data() + sv.size());
+        return *this;
+    }
+
+    template <class C>
+    stream_iter& write(C c, std::size_t count) {
+        _buf->append(count, static_cast<CharT>(c));
+        return *this;
+    }
+
+    template <class T>
+    stream_iter& write_stable(std::basic_string_view<CharT, T> sv) {
+        _buf->append_stable(sv.data(), sv.size());
+        return *this;
+    }
+
+    stream_buffer<CharT>& container() const noexcept { return *_buf; }
+};
+
+inline constexpr std::size_t thread_local_buffer_retain =
+      LRSTD_THREAD_LOCAL_BUFFER_RETAIN;
+
+// memory buffers kept per thread and reused from call to call. capacity
+// above thread_local_buffer_retain is given back the next time one is
+// acquired. a formatter that formats again while a buffer is in use (further
+// up the same thread's stack) doesn't get it.
+template <class CharT>
+class thread_local_buffer {
+    basic_memory_buffer<CharT> _buf;
+    bool _in_use = false;
+
+    thread_local_buffer() = default;
+
+   public:
+    // scratch space for results that are copied out before returning
+    static thread_local_buffer& for_strings() {
+        static thread_local thread_local_buffer tlb;
+        return tlb;
+    }
+    // storage for results handed out as views
+    static thread_local_buffer& for_views() {
+        static thread_local thread_local_buffer tlb;
+        return tlb;
+    }
+
+    class lease {
+        thread_local_buffer& _owner;
+        basic_memory_buffer<CharT>* _buf;
+
+       public:
+        explicit lease(thread_local_buffer& owner)
+            : _owner{owner}, _buf{owner.acquire()} {}
+        lease(const lease&) = delete;
+        lease& operator=(const lease&) = delete;
+        ~lease() {
+            if (_buf)
+                _owner._in_use = false;
+        }
+
+        // null if the buffer was already in use
+        basic_memory_buffer<CharT>* get() const noexcept { return _buf; }
+    };
+
+   private:
+    basic_memory_buffer<CharT>* acquire() {
+        if (_in_use)
+            return nullptr;
+        _buf.clear();
+        _buf.shrink_to(thread_local_buffer_retain);
+        _in_use = true;
+        return &_buf;
+    }
+};
+
+}  // namespace detail
+
+// output that is handed to callback, as basic_string_views, N characters at
+// a time. format into it with format_to(sink.out(), ...) and call flush()
+// at the end. literal text and string arguments of at least borrow_min
+// characters are passed to the callback where they are, without being
+// copied into the buffer first.
+template <class CharT, class Callback, std::size_t N = 4096>
+class basic_callback_sink : public detail::stream_buffer<CharT> {
+    Callback _callback;
+    CharT _data[N];
+
+    static void emit(void* callback, std::basic_string_view<CharT> chunk) {
+        (*static_cast<Callback*>(callback))(chunk);
+    }
+
+   public:
+    explicit basic_callback_sink(Callback callback, std::size_t borrow_min = N)
+        : detail::stream_buffer<CharT>{&emit, &_callback, borrow_min}
+        , _callback(std::move(callback)) {
+        this->set(_data, N);
+    }
+
+    detail::stream_iter<CharT> out() noexcept {
+        return detail::stream_iter<CharT>(*this);
+    }
+};
+
+template <class Callback, std::size_t N = 4096>
+using callback_sink = basic_callback_sink<char, Callback, N>;
+template <class Callback, std::size_t N = 4096>
+using wcallback_sink = basic_callback_sink<wchar_t, Callback, N>;
+
+}  // namespace lrstd
+
+#endif
@@ -8,9 +8,17 @@
 #include <type_traits>
 #include <vector>
 
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_span)
+#include <span>
+#endif
+
 #define LRSTD_UNREACHABLE() __builtin_unreachable()
 #define LRSTD_ASSERT(...) assert(__VA_ARGS__)
 #define LRSTD_ALWAYS_INLINE __attribute__((always_inline))
+#define LRSTD_USED __attribute__((used))
 
 // #define LRSTD_USE_EXTRA_CONSTEXPR false
 
@@ -20,6 +28,26 @@
 #define LRSTD_EXTRA_CONSTEXPR
 #endif
 
+// format into a per-thread buffer that is reused between calls, instead of a
+// fresh one each time
+// #define LRSTD_USE_THREAD_LOCAL_BUFFER true
+
+// how much capacity the per-thread buffer holds on to between calls
+#ifndef LRSTD_THREAD_LOCAL_BUFFER_RETAIN
+#define LRSTD_THREAD_LOCAL_BUFFER_RETAIN 65536
+#endif
+
+// leave <locale> out of format.hpp; the std::locale overloads and the global
+// locale for 'L' then come with format_locale.hpp
+// #define LRSTD_FORMAT_NO_LOCALE true
+
+// the formatting entry points for char and wchar_t are instantiated once, in
+// the format_compiled library, instead of in every translation unit. set by
+// linking against format_compiled, which has to be built with the same
+// LRSTD_USE_THREAD_LOCAL_BUFFER and LRSTD_USE_EXTRA_CONSTEXPR as the code
+// using it; a mismatch fails to link.
+// #define LRSTD_FORMAT_COMPILED true
+
 namespace lrstd {
 
 template <class It>
@@ -44,6 +72,9 @@ inline constexpr bool is_unsigned_integer_v =
 template <class It, class = void>
 struct hack_is_contiguous_iterator : std::false_type {};
 
+// std::array<T, N>::iterator is a plain T* in libstdc++ and libc++, so the
+// pointer check covers it there. everywhere else std::array (and any other
+// contiguous iterator) is picked up by the concept when it's available.
 template <class It>
 struct hack_is_contiguous_iterator<
       It,
@@ -61,7 +92,19 @@ struct hack_is_contiguous_iterator<
             std::is_same<
                   It,
                   typename std::basic_string_view<typename std::iterator_traits<
-                        It>::value_type>::iterator>>> {};
+                        It>::value_type>::iterator>
+#if defined(__cpp_lib_span)
+            ,
+            std::is_same<It,
+                         typename std::span<typename std::iterator_traits<
+                               It>::value_type>::iterator>
+#endif
+#if defined(__cpp_lib_concepts)
+            ,
+            std::bool_constant<std::contiguous_iterator<It>>
+#endif
+            >> {
+};
 
 template <class It>
 inline constexpr bool hack_is_contiguous_iterator_v =
@@ -96,6 +139,22 @@ constexpr auto maybe_to_raw_pointer(It it) noexcept(
     return maybe_to_raw_pointer_impl<It>{}(it);
 }
 
+// contiguous, writable iterators that format_to can replace with a raw pointer
+// for the duration of the call, so that every writer takes its char_traits
+// path
+template <class It, class = void>
+struct is_lowerable_iterator : std::false_type {};
+template <class It>
+struct is_lowerable_iterator<
+      It,
+      std::enable_if_t<hack_is_contiguous_iterator_v<It> &&
+                       !std::is_pointer_v<It>>>
+    : std::bool_constant<!std::is_const_v<std::remove_pointer_t<
+            decltype(to_raw_pointer(std::declval<It>()))>>> {};
+
+template <class It>
+inline constexpr bool is_lowerable_iterator_v = is_lowerable_iterator<It>::value;
+
 template <class It, class T>
 constexpr It to_iter(T* ptr, It it) noexcept(
       noexcept(std::next(it, std::distance(to_raw_pointer(it), ptr)))) {
@@ -5,7 +5,9 @@
 
 #include <cstdint>
 #include <iterator>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 namespace lrstd::detail {
 
@@ -13,33 +15,34 @@ template <class CharT>
 inline constexpr bool is_char_or_wchar_t_v =
       std::is_same_v<char, CharT> || std::is_same_v<wchar_t, CharT>;
 
-template <class CharT>
-class build_buf_iter
-    : public std::back_insert_iterator<std::basic_string<CharT>> {
-   private:
-    using base = std::back_insert_iterator<std::basic_string<CharT>>;
-    using base::container;
-
-   public:
-    explicit build_buf_iter(std::basic_string<CharT>& s) : base(s) {}
-
-    build_buf_iter& write(std::basic_string_view<CharT> sv) {
-        container->append(sv);
-        return *this;
-    }
-    template <class C, class T>
-    build_buf_iter& write(std::basic_string_view<C, T> sv) {
-        container->append(sv.begin(), sv.end());
-        return *this;
-    }
-
-    template <class C>
-    build_buf_iter& write(C c, std::size_t count) {
-        container->append(count, c);
-        return *this;
+// containers whose back_insert_iterators can be written to in bulk
+template <class Container>
+struct is_contiguous_char_container : std::false_type {};
+template <class CharT, class Traits, class Alloc>
+struct is_contiguous_char_container<std::basic_string<CharT, Traits, Alloc>>
+    : std::bool_constant<is_char_or_wchar_t_v<CharT>> {};
+template <class CharT, class Alloc>
+struct is_contiguous_char_container<std::vector<CharT, Alloc>>
+    : std::bool_constant<is_char_or_wchar_t_v<CharT>> {};
+
+template <class Container>
+inline constexpr bool is_contiguous_char_container_v =
+      is_contiguous_char_container<Container>::value;
+
+// std::back_insert_iterator only exposes its container to derived classes
+template <class Container>
+struct back_insert_container_access
+    : std::back_insert_iterator<Container> {
+    static Container& get(std::back_insert_iterator<Container> it) noexcept {
+        return *(it.*&back_insert_container_access::container);
     }
 };
 
+template <class Container>
+Container& get_container(std::back_insert_iterator<Container> it) noexcept {
+    return back_insert_container_access<Container>::get(it);
+}
+
 class count_iter {
     std::size_t _count = 0;
 
@@ -61,6 +64,12 @@ class count_iter {
         return *this;
     }
 
+    // counts n characters at once
+    constexpr count_iter& advance(std::size_t n) noexcept {
+        _count += n;
+        return *this;
+    }
+
     constexpr std::size_t count() const noexcept { return _count; }
 };
 
@@ -130,6 +139,69 @@ class write_n_iter {
     }
 };
 
+// like write_n_iter, but without keeping count of what doesn't fit. once
+// anything has been cut off, the formatting loop stops early.
+template <class It>
+class truncating_iter {
+    It it;
+    std::size_t remaining;
+    bool cut;
+
+   public:
+    constexpr truncating_iter(std::size_t n, It it)
+        : it{it}, remaining{n}, cut{false} {}
+
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+
+    constexpr truncating_iter& operator*() noexcept { return *this; }
+    constexpr truncating_iter& operator++() noexcept { return *this; }
+    constexpr truncating_iter& operator++(int) noexcept { return *this; }
+
+    template <class CharT,
+              class = std::enable_if_t<is_char_or_wchar_t_v<CharT>>>
+    constexpr truncating_iter& operator=(CharT c) noexcept {
+        if (remaining != 0) {
+            *it++ = c;
+            --remaining;
+        } else
+            cut = true;
+        return *this;
+    }
+
+    template <class C, class UnderlyingWriter>
+    constexpr truncating_iter& write(C c,
+                                     std::size_t count,
+                                     UnderlyingWriter writer) {
+        const auto to_write = std::min(count, remaining);
+        it = writer(c, to_write, it);
+        remaining -= to_write;
+        cut |= count > to_write;
+        return *this;
+    }
+
+    template <class C, class T, class UnderlyingWriter>
+    constexpr truncating_iter& write(std::basic_string_view<C, T> str,
+                                     UnderlyingWriter writer) {
+        auto truncated_str = str.substr(0, remaining);
+        it = writer(truncated_str, it);
+        remaining -= truncated_str.size();
+        cut |= str.size() > truncated_str.size();
+        return *this;
+    }
+
+    constexpr It iter() const { return it; }
+    constexpr bool truncated() const noexcept { return cut; }
+};
+
+template <class Out>
+struct is_truncating_iter : std::false_type {};
+template <class It>
+struct is_truncating_iter<truncating_iter<It>> : std::true_type {};
+
 }  // namespace lrstd::detail
 
 #endif
@@ -0,0 +1,74 @@
+#ifndef LRSTD_FORMAT_LOCALE_REF_HPP
+#define LRSTD_FORMAT_LOCALE_REF_HPP
+
+#include "_common.hpp"
+
+#include <string>
+#include <type_traits>
+
+namespace lrstd::detail {
+
+[[noreturn]] inline void throw_format_error(const char* w) noexcept(false);
+
+// what formatting with 'L' takes from a locale: its numpunct<CharT>. the
+// defaults are the classic locale's.
+template <class CharT>
+struct numpunct_data {
+    CharT thousands_sep = ',';
+    std::string grouping;
+    std::basic_string<CharT> truename = {CharT('t'), CharT('r'), CharT('u'),
+                                         CharT('e')};
+    std::basic_string<CharT> falsename = {CharT('f'), CharT('a'), CharT('l'),
+                                          CharT('s'), CharT('e')};
+};
+
+// how to read a locale, so that the core never needs <locale>.
+// format_locale.hpp provides these for std::locale. a null locale stands
+// for the global one.
+struct locale_hooks {
+    numpunct_data<char> (*numpunct)(const void* loc);
+    numpunct_data<wchar_t> (*wnumpunct)(const void* loc);
+};
+
+// the hooks for the global locale. format_locale.hpp, which format.hpp
+// includes unless LRSTD_FORMAT_NO_LOCALE is set, installs them before
+// anything in the including translation unit is initialized.
+inline const locale_hooks* global_locale_hooks = nullptr;
+
+// the locale a format function was given, if any
+class locale_ref {
+    const void* _locale = nullptr;
+    const locale_hooks* _hooks = nullptr;
+
+   public:
+    constexpr locale_ref() noexcept = default;
+    template <class Locale>
+    constexpr locale_ref(const Locale& loc, const locale_hooks& hooks) noexcept
+        : _locale{&loc}, _hooks{&hooks} {}
+
+    // the locale, or the global one if there isn't one
+    template <class Locale>
+    Locale get() const {
+        return _locale ? *static_cast<const Locale*>(_locale) : Locale();
+    }
+
+    template <class CharT>
+    numpunct_data<CharT> numpunct() const {
+        const locale_hooks* const hooks = _hooks ? _hooks : global_locale_hooks;
+        if (!hooks)
+            throw_format_error(
+                  "'L' without a locale needs format_locale.hpp");
+        if constexpr (std::is_same_v<CharT, char>)
+            return hooks->numpunct(_locale);
+        else
+            return hooks->wnumpunct(_locale);
+    }
+};
+
+// specialized by format_locale.hpp for std::locale, and for void to name it
+template <class Locale>
+struct locale_traits {};
+
+}  // namespace lrstd::detail
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef LRSTD_FORMAT_WRITER_HPP
 #define LRSTD_FORMAT_WRITER_HPP
 
+#include "_buffer.hpp"
 #include "_common.hpp"
 #include "_iter.hpp"
 
@@ -37,13 +38,49 @@ struct repeated_char_writer {
     }
 #endif
 
-    // build_buf_iter optimization
+    // buffer_iter optimization
     template <class CharT, class OutCharT>
-    constexpr build_buf_iter<OutCharT>
-    operator()(CharT c, std::size_t count, build_buf_iter<OutCharT> out) const {
+    constexpr buffer_iter<OutCharT>
+    operator()(CharT c, std::size_t count, buffer_iter<OutCharT> out) const {
         return out.write(c, count);
     }
 
+    template <class CharT, class OutCharT>
+    scatter_iter<OutCharT> operator()(CharT c,
+                                      std::size_t count,
+                                      scatter_iter<OutCharT> out) const {
+        return out.write(c, count);
+    }
+    template <class CharT, class OutCharT>
+    stream_iter<OutCharT> operator()(CharT c,
+                                     std::size_t count,
+                                     stream_iter<OutCharT> out) const {
+        return out.write(c, count);
+    }
+
+    // back_insert_iterator<string/vector> optimization
+    template <class CharT,
+              class Container,
+              class = std::enable_if_t<
+                    is_contiguous_char_container_v<Container>>>
+    std::back_insert_iterator<Container> operator()(
+          CharT c,
+          std::size_t count,
+          std::back_insert_iterator<Container> out) const {
+        Container& container = get_container(out);
+        container.insert(container.end(), count,
+                         static_cast<typename Container::value_type>(c));
+        return out;
+    }
+
+    // count_iter optimization
+    template <class CharT>
+    constexpr count_iter operator()(CharT,
+                                    std::size_t count,
+                                    count_iter out) const noexcept {
+        return out.advance(count);
+    }
+
     // write_n optimization
     template <class CharT, class It>
     constexpr write_n_iter<It> operator()(CharT c,
@@ -51,6 +88,12 @@ struct repeated_char_writer {
                                           write_n_iter<It> w) const {
         return w.write(c, count, *this);
     }
+    template <class CharT, class It>
+    constexpr truncating_iter<It> operator()(CharT c,
+                                             std::size_t count,
+                                             truncating_iter<It> w) const {
+        return w.write(c, count, *this);
+    }
 };
 
 struct str_writer_common {
@@ -60,13 +103,44 @@ struct str_writer_common {
         return std::copy(str.begin(), str.end(), out);
     }
 
-    // build_buf_iter optimization
+    // buffer_iter optimization
     template <class CharT, class Traits, class OutCharT>
-    constexpr build_buf_iter<OutCharT> operator()(
+    constexpr buffer_iter<OutCharT> operator()(
           std::basic_string_view<CharT, Traits> str,
-          build_buf_iter<OutCharT> out) const {
+          buffer_iter<OutCharT> out) const {
+        return out.write(str);
+    }
+    template <class CharT, class Traits, class OutCharT>
+    scatter_iter<OutCharT> operator()(std::basic_string_view<CharT, Traits> str,
+                                      scatter_iter<OutCharT> out) const {
+        return out.write(str);
+    }
+    template <class CharT, class Traits, class OutCharT>
+    stream_iter<OutCharT> operator()(std::basic_string_view<CharT, Traits> str,
+                                     stream_iter<OutCharT> out) const {
         return out.write(str);
     }
+
+    // back_insert_iterator<string/vector> optimization
+    template <class CharT,
+              class Traits,
+              class Container,
+              class = std::enable_if_t<
+                    is_contiguous_char_container_v<Container>>>
+    std::back_insert_iterator<Container> operator()(
+          std::basic_string_view<CharT, Traits> str,
+          std::back_insert_iterator<Container> out) const {
+        Container& container = get_container(out);
+        container.insert(container.end(), str.begin(), str.end());
+        return out;
+    }
+
+    // count_iter optimization
+    template <class CharT, class Traits>
+    constexpr count_iter operator()(std::basic_string_view<CharT, Traits> str,
+                                    count_iter out) const noexcept {
+        return out.advance(str.size());
+    }
 };
 template <class Derived>
 struct str_write_n_optimization {
@@ -76,6 +150,12 @@ struct str_write_n_optimization {
           write_n_iter<It> w) const {
         return w.write(str, static_cast<const Derived&>(*this));
     }
+    template <class CharT, class Traits, class It>
+    constexpr truncating_iter<It> operator()(
+          std::basic_string_view<CharT, Traits> str,
+          truncating_iter<It> w) const {
+        return w.write(str, static_cast<const Derived&>(*this));
+    }
 };
 struct overlapping_str_writer
     : str_writer_common
@@ -92,6 +172,56 @@ struct overlapping_str_writer
     }
 #endif
 };
+// marks text written while it is alive as outliving the format call: the
+// format string's literal text and string arguments. outputs that can refer
+// to such text in place, instead of copying it, specialize this.
+template <class Out>
+struct stable_text_scope {
+    constexpr explicit stable_text_scope(const Out&) noexcept {}
+};
+template <class Buffer>
+class buffer_stable_text_scope {
+    Buffer& _buf;
+    bool _old;
+
+   public:
+    template <class Out>
+    explicit buffer_stable_text_scope(const Out& out) noexcept
+        : _buf{out.container()}, _old{_buf.set_stable(true)} {}
+    buffer_stable_text_scope(const buffer_stable_text_scope&) = delete;
+    buffer_stable_text_scope& operator=(const buffer_stable_text_scope&) =
+          delete;
+    ~buffer_stable_text_scope() { _buf.set_stable(_old); }
+};
+template <class CharT>
+struct stable_text_scope<scatter_iter<CharT>>
+    : buffer_stable_text_scope<scatter_buffer<CharT>> {
+    using buffer_stable_text_scope<scatter_buffer<CharT>>::
+          buffer_stable_text_scope;
+};
+template <class CharT>
+struct stable_text_scope<stream_iter<CharT>>
+    : buffer_stable_text_scope<stream_buffer<CharT>> {
+    using buffer_stable_text_scope<stream_buffer<CharT>>::
+          buffer_stable_text_scope;
+};
+
+// for text that may be covered by a stable_text_scope
+struct stable_str_writer : overlapping_str_writer {
+    using overlapping_str_writer::operator();
+
+    template <class CharT, class Traits>
+    scatter_iter<CharT> operator()(std::basic_string_view<CharT, Traits> str,
+                                   scatter_iter<CharT> out) const {
+        return out.write_stable(str);
+    }
+    template <class CharT, class Traits>
+    stream_iter<CharT> operator()(std::basic_string_view<CharT, Traits> str,
+                                  stream_iter<CharT> out) const {
+        return out.write_stable(str);
+    }
+};
+
 struct overlapping_generic_writer
     : overloaded<overlapping_str_writer,
                  single_char_writer,
@@ -116,6 +246,55 @@ struct nonoverlapping_generic_writer
                  single_char_writer,
                  repeated_char_writer> {};
 
+// outputs that the writers above handle well enough on their own. anything
+// else gets an iterator_buffer in front of it for the duration of a format_to.
+template <class Out>
+struct is_direct_output : std::is_pointer<Out> {};
+template <class CharT>
+struct is_direct_output<buffer_iter<CharT>> : std::true_type {};
+template <>
+struct is_direct_output<count_iter> : std::true_type {};
+template <class CharT>
+struct is_direct_output<scatter_iter<CharT>> : std::true_type {};
+template <class CharT>
+struct is_direct_output<stream_iter<CharT>> : std::true_type {};
+template <class It>
+struct is_direct_output<write_n_iter<It>> : std::true_type {};
+template <class It>
+struct is_direct_output<truncating_iter<It>> : std::true_type {};
+template <class Container>
+struct is_direct_output<std::back_insert_iterator<Container>>
+    : is_contiguous_char_container<Container> {};
+
+template <class Out>
+inline constexpr bool is_direct_output_v = is_direct_output<Out>::value;
+
+// outputs that keep a formatting context of their own when everything else
+// is formatted through buffer_iter (see erase_outputs): buffer_iter itself,
+// the counting of formatted_size, and outputs that borrow stable text
+template <class Out>
+struct has_own_context : std::false_type {};
+template <class CharT>
+struct has_own_context<buffer_iter<CharT>> : std::true_type {};
+template <>
+struct has_own_context<count_iter> : std::true_type {};
+template <class CharT>
+struct has_own_context<scatter_iter<CharT>> : std::true_type {};
+template <class CharT>
+struct has_own_context<stream_iter<CharT>> : std::true_type {};
+
+template <class Out>
+inline constexpr bool has_own_context_v = has_own_context<Out>::value;
+
+// back_insert_iterators that can be written through a string_append_buffer
+template <class Out, class CharT>
+struct is_back_inserter_for : std::false_type {};
+template <class Container, class CharT>
+struct is_back_inserter_for<std::back_insert_iterator<Container>, CharT>
+    : std::bool_constant<
+            is_contiguous_char_container_v<Container> &&
+            std::is_same_v<typename Container::value_type, CharT>> {};
+
 }  // namespace lrstd::detail
 
 #endif
@@ -1,8 +1,11 @@
 #ifndef LRSTD_FORMAT_HPP
 #define LRSTD_FORMAT_HPP
 
+#include "_arena.hpp"
+#include "_buffer.hpp"
 #include "_common.hpp"
 #include "_iter.hpp"
+#include "_locale.hpp"
 #include "_writer.hpp"
 
 #include <algorithm>
@@ -12,13 +15,16 @@
 #include <climits>
 #include <cstring>
 #include <functional>
-#include <locale>
+#include <limits>
+#include <memory>
+#include <new>
 #include <numeric>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -121,9 +127,9 @@ using basic_string_view = std::basic_string_view<CharT>;
 
 template <class Out, class CharT>
 class basic_format_context;
-using format_context = basic_format_context<detail::build_buf_iter<char>, char>;
+using format_context = basic_format_context<detail::buffer_iter<char>, char>;
 using wformat_context =
-      basic_format_context<detail::build_buf_iter<wchar_t>, wchar_t>;
+      basic_format_context<detail::buffer_iter<wchar_t>, wchar_t>;
 
 template <class CharT>
 class basic_format_parse_context;
@@ -132,6 +138,8 @@ using wformat_parse_context = basic_format_parse_context<wchar_t>;
 
 template <class Context>
 class basic_format_args;
+template <class Context>
+class dynamic_format_arg_store;
 using format_args = basic_format_args<format_context>;
 using wformat_args = basic_format_args<wformat_context>;
 template <class Out, class CharT>
@@ -140,6 +148,9 @@ using format_args_t = basic_format_args<basic_format_context<Out, CharT>>;
 template <class T, class CharT>
 struct formatter;
 
+template <class CharT>
+class basic_chunked_formatter;
+
 namespace detail {
 template <class CharT, class Out>
 LRSTD_EXTRA_CONSTEXPR Out vformat_to_impl(Out out,
@@ -147,13 +158,27 @@ LRSTD_EXTRA_CONSTEXPR Out vformat_to_impl(Out out,
                                           format_args_t<Out, CharT>& args);
 template <class CharT, class Out>
 LRSTD_EXTRA_CONSTEXPR Out vformat_to_impl(Out out,
-                                          const std::locale&,
+                                          locale_ref loc,
                                           basic_string_view<CharT> fmt,
                                           format_args_t<Out, CharT>& args);
 template <class CharT, class Out>
 LRSTD_EXTRA_CONSTEXPR Out
 vformat_to_core(basic_format_context<Out, CharT>& context,
                 basic_string_view<CharT> fmt_sv);
+template <class CharT, class Out, class Done>
+LRSTD_EXTRA_CONSTEXPR void format_pieces(
+      basic_format_context<Out, CharT>& context,
+      basic_format_parse_context<CharT>& parse_context,
+      Done done);
+template <class CharT, class Done>
+void vformat_to_buffer(buffer<CharT>& buf,
+                       locale_ref loc,
+                       basic_string_view<CharT> fmt,
+                       format_args_t<buffer_iter<CharT>, CharT> args,
+                       Done done);
+template <class Out, class CharT>
+constexpr locale_ref context_locale(
+      const basic_format_context<Out, CharT>& context) noexcept;
 
 template <class CharT>
 struct range {
@@ -361,6 +386,23 @@ namespace detail {
 template <class Context, class... Args>
 struct format_arg_store;
 
+// one entry per argument of a format_arg_store, filled in when the store is
+// created so that the argument's formatter can be called without decoding its
+// tag first
+template <class Context>
+struct arg_dispatch {
+    void (*format)(const void* data,
+                   std::size_t i,
+                   Context& fc,
+                   basic_format_parse_context<typename Context::char_type>& pc);
+};
+template <class Context, class S, bool IsSmall>
+LRSTD_EXTRA_CONSTEXPR void dispatch_arg(
+      const void* data,
+      std::size_t i,
+      Context& fc,
+      basic_format_parse_context<typename Context::char_type>& pc);
+
 enum class arg_tag : char {
     empty,
     b,
@@ -485,6 +527,37 @@ union arg_storage {
     constexpr arg_storage(arg_handle<Context> h) noexcept : h{h} {}
 };
 
+template <class S, class Context>
+constexpr const S& get_storage(const arg_storage<Context>& s) noexcept {
+    constexpr arg_tag tag = tag_for<S>();
+    if constexpr (tag == arg_tag::empty)
+        return s.empty;
+    else if constexpr (tag == arg_tag::b)
+        return s.b;
+    else if constexpr (tag == arg_tag::c)
+        return s.c;
+    else if constexpr (tag == arg_tag::i)
+        return s.i;
+    else if constexpr (tag == arg_tag::ui)
+        return s.ui;
+    else if constexpr (tag == arg_tag::lli)
+        return s.lli;
+    else if constexpr (tag == arg_tag::ulli)
+        return s.ulli;
+    else if constexpr (tag == arg_tag::d)
+        return s.d;
+    else if constexpr (tag == arg_tag::ld)
+        return s.ld;
+    else if constexpr (tag == arg_tag::cptr)
+        return s.cptr;
+    else if constexpr (tag == arg_tag::sv)
+        return s.sv;
+    else if constexpr (tag == arg_tag::vptr)
+        return s.vptr;
+    else
+        return s.h;
+}
+
 template <class Context,
           class T,
           typename = std::enable_if_t<std::is_same_v<
@@ -552,6 +625,63 @@ LRSTD_EXTRA_CONSTEXPR auto to_storage_type(T* p) noexcept {
     return static_cast<const void*>(p);
 }
 
+template <class CharT, class T>
+struct named_arg {
+    basic_string_view<CharT> name;
+    const T& value;
+};
+
+template <class T>
+struct is_named_arg : std::false_type {};
+template <class CharT, class T>
+struct is_named_arg<named_arg<CharT, T>> : std::true_type {};
+template <class T>
+inline constexpr bool is_named_arg_v = is_named_arg<T>::value;
+
+template <class Context, class T>
+LRSTD_EXTRA_CONSTEXPR auto to_storage_type(
+      const named_arg<typename Context::char_type, T>& a) noexcept {
+    return to_storage_type<Context>(a.value);
+}
+
+template <class Context>
+struct named_arg_entry {
+    basic_string_view<typename Context::char_type> name;
+    std::size_t id;
+};
+
+// named argument lists are short, so a plain insertion sort does fine here
+template <class Context>
+LRSTD_EXTRA_CONSTEXPR void sort_named_args(named_arg_entry<Context>* first,
+                                           named_arg_entry<Context>* last) {
+    for (auto it = first; it != last; ++it) {
+        for (auto j = it; j != first && j->name < (j - 1)->name; --j) {
+            const named_arg_entry<Context> tmp = *j;
+            *j = *(j - 1);
+            *(j - 1) = tmp;
+        }
+    }
+    for (auto it = first; it != last && it + 1 != last; ++it) {
+        if (it->name == (it + 1)->name)
+            throw_format_error("duplicate named argument");
+    }
+}
+
+template <class Context>
+LRSTD_EXTRA_CONSTEXPR const named_arg_entry<Context>* find_named_arg(
+      const named_arg_entry<Context>* first,
+      const named_arg_entry<Context>* last,
+      basic_string_view<typename Context::char_type> name) noexcept {
+    while (first != last) {
+        const auto mid = first + (last - first) / 2;
+        if (mid->name < name)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return first;
+}
+
 }  // namespace detail
 
 template <class Context>
@@ -587,6 +717,16 @@ struct basic_format_arg {
     template <class C>
     friend class basic_format_args;
 
+    template <class C>
+    friend class dynamic_format_arg_store;
+
+    template <class C, class S, bool IsSmall>
+    friend LRSTD_EXTRA_CONSTEXPR void detail::dispatch_arg(
+          const void*,
+          std::size_t,
+          C&,
+          basic_format_parse_context<typename C::char_type>&);
+
    public:
     LRSTD_EXTRA_CONSTEXPR basic_format_arg() noexcept
         : value{std::monostate{}}, tag{detail::arg_tag::empty} {}
@@ -686,9 +826,37 @@ struct format_arg_store {
             return arg_count;
     }
 
+    static constexpr std::array<arg_dispatch<Context>, arg_count>
+          dispatch_table{{{&dispatch_arg<
+                Context,
+                decltype(to_storage_type<Context>(std::declval<Args>())),
+                is_small>}...}};
+
+    static constexpr std::size_t named_count =
+          (std::size_t{is_named_arg_v<Args>} + ... + 0);
+    std::array<named_arg_entry<Context>, named_count> named_entries;
+
     constexpr explicit format_arg_store(const Args&... args)
         : storage{typename storage_type::value_type(
-                to_storage_type<Context>(args))...} {}
+                to_storage_type<Context>(args))...}
+        , named_entries{} {
+        if constexpr (named_count != 0) {
+            std::size_t id = 0;
+            std::size_t n = 0;
+            (add_named_entry(args, id++, n), ...);
+            sort_named_args(named_entries.data(),
+                            named_entries.data() + named_count);
+        }
+    }
+
+   private:
+    template <class T>
+    constexpr void add_named_entry(const T& arg,
+                                   std::size_t id,
+                                   std::size_t& n) noexcept {
+        if constexpr (is_named_arg_v<T>)
+            named_entries[n++] = named_arg_entry<Context>{arg.name, id};
+    }
 };
 }  // namespace detail
 
@@ -696,6 +864,9 @@ template <class Context>
 class basic_format_args {
     std::size_t _size;
     const void* _data;
+    const detail::arg_dispatch<Context>* _dispatch;
+    const detail::named_arg_entry<Context>* _named;
+    std::size_t _named_size;
 
     template <class, class>
     friend class basic_format_context;
@@ -731,12 +902,28 @@ class basic_format_args {
 
    public:
     LRSTD_EXTRA_CONSTEXPR basic_format_args() noexcept
-        : _size{0}, _data{nullptr} {}
+        : _size{0}
+        , _data{nullptr}
+        , _dispatch{nullptr}
+        , _named{nullptr}
+        , _named_size{0} {}
 
     template <class... Args>
     LRSTD_EXTRA_CONSTEXPR basic_format_args(
           const detail::format_arg_store<Context, Args...>& store) noexcept
-        : _size{store.size_field()}, _data{&store.storage} {}
+        : _size{store.size_field()}
+        , _data{&store.storage}
+        , _dispatch{store.dispatch_table.data()}
+        , _named{store.named_entries.data()}
+        , _named_size{store.named_count} {}
+
+    LRSTD_EXTRA_CONSTEXPR basic_format_args(
+          const dynamic_format_arg_store<Context>& store) noexcept
+        : _size{store._args.size()}
+        , _data{store._args.data()}
+        , _dispatch{nullptr}
+        , _named{store._named.data()}
+        , _named_size{store._named.size()} {}
 
     LRSTD_EXTRA_CONSTEXPR basic_format_arg<Context> get(std::size_t i) const
           noexcept {
@@ -746,28 +933,48 @@ class basic_format_args {
     constexpr std::size_t _get_size() const noexcept {
         return is_small() ? get_small_size() : _size;
     }
+
+    // formats argument i straight through the store's dispatch table.
+    // returns false if there is no table or i is out of range, in which case
+    // the caller has to fall back to visiting get(i).
+    template <class ParseContext>
+    LRSTD_EXTRA_CONSTEXPR bool _dispatch_arg(std::size_t i,
+                                             std::size_t size,
+                                             Context& fc,
+                                             ParseContext& pc) const {
+        if (!_dispatch || i >= size)
+            return false;
+        _dispatch[i].format(_data, i, fc, pc);
+        return true;
+    }
+
+    template <class CharT>
+    LRSTD_EXTRA_CONSTEXPR std::size_t _get_named_id(
+          basic_string_view<CharT> name) const {
+        const auto last = _named + _named_size;
+        const auto entry = detail::find_named_arg(_named, last, name);
+        if (entry == last || entry->name != name)
+            detail::throw_format_error("argument not found");
+        return entry->id;
+    }
 };
 
 template <class Out, class CharT>
 class basic_format_context {
     basic_format_args<basic_format_context> _args;
     Out _out;
-    std::optional<std::locale> _locale;
+    detail::locale_ref _locale;
 
-    LRSTD_EXTRA_CONSTEXPR basic_format_context(
-          const basic_format_args<basic_format_context>& args,
-          Out out)
-        : _args{args}, _out{out} {}
     LRSTD_EXTRA_CONSTEXPR basic_format_context(
           const basic_format_args<basic_format_context>& args,
           Out out,
-          const std::locale& loc)
+          detail::locale_ref loc = {})
         : _args{args}, _out{out}, _locale{loc} {}
 
     template <class C, class O>
     friend LRSTD_EXTRA_CONSTEXPR O
     detail::vformat_to_impl(O out,
-                            const std::locale&,
+                            detail::locale_ref loc,
                             basic_string_view<C> fmt,
                             format_args_t<O, C>& args);
     template <class C, class O>
@@ -780,8 +987,33 @@ class basic_format_context {
     friend LRSTD_EXTRA_CONSTEXPR O
     detail::vformat_to_core(basic_format_context<O, C>& context,
                             basic_string_view<C> fmt_sv);
+    template <class C, class O, class D>
+    friend LRSTD_EXTRA_CONSTEXPR void detail::format_pieces(
+          basic_format_context<O, C>& context,
+          basic_format_parse_context<C>& parse_context,
+          D done);
+    template <class C, class D>
+    friend void detail::vformat_to_buffer(
+          detail::buffer<C>& buf,
+          detail::locale_ref loc,
+          basic_string_view<C> fmt,
+          format_args_t<detail::buffer_iter<C>, C> args,
+          D done);
+    template <class O, class C>
+    friend constexpr detail::locale_ref detail::context_locale(
+          const basic_format_context<O, C>& context) noexcept;
+    template <class C>
+    friend class basic_chunked_formatter;
 
     constexpr std::size_t args_size() const { return _args._get_size(); }
+    constexpr std::size_t arg_id(basic_string_view<CharT> name) const {
+        return _args._get_named_id(name);
+    }
+    constexpr bool dispatch_arg(std::size_t id_,
+                                std::size_t size,
+                                basic_format_parse_context<CharT>& pc) {
+        return _args._dispatch_arg(id_, size, *this, pc);
+    }
 
    public:
     using iterator = Out;
@@ -794,12 +1026,26 @@ class basic_format_context {
         return _args.get(id_);
     }
 
-    std::locale locale() { return _locale ? *_locale : std::locale(); }
+    // the locale given to the format function, or else the global locale.
+    // std::locale comes with format_locale.hpp.
+    template <class T = void,
+              class Locale = typename detail::locale_traits<T>::type>
+    Locale locale() {
+        return _locale.get<Locale>();
+    }
 
     LRSTD_EXTRA_CONSTEXPR iterator out() noexcept { return _out; }
     LRSTD_EXTRA_CONSTEXPR void advance_to(iterator it) { _out = it; }
 };
 
+namespace detail {
+template <class Out, class CharT>
+constexpr locale_ref context_locale(
+      const basic_format_context<Out, CharT>& context) noexcept {
+    return context._locale;
+}
+}  // namespace detail
+
 template <class Context = format_context, class... Args>
 LRSTD_EXTRA_CONSTEXPR detail::format_arg_store<Context, Args...>
 make_format_args(const Args&... args) {
@@ -812,6 +1058,152 @@ make_wformat_args(const Args&... args) {
     return make_format_args<wformat_context>(args...);
 }
 
+// names an argument so that it can be referred to as {name} in the format
+// string. the returned object refers to both name and value.
+template <class CharT, class T>
+constexpr detail::named_arg<CharT, T> arg(const CharT* name,
+                                          const T& value) noexcept {
+    return detail::named_arg<CharT, T>{name, value};
+}
+
+namespace detail {
+template <class T, class CharT>
+struct is_dynamic_string : std::false_type {};
+template <class CharT>
+struct is_dynamic_string<CharT*, CharT> : std::true_type {};
+template <class CharT>
+struct is_dynamic_string<const CharT*, CharT> : std::true_type {};
+template <class CharT, std::size_t N>
+struct is_dynamic_string<CharT[N], CharT> : std::true_type {};
+template <class CharT, class Traits>
+struct is_dynamic_string<std::basic_string_view<CharT, Traits>, CharT>
+    : std::true_type {};
+template <class CharT, class Traits, class Alloc>
+struct is_dynamic_string<std::basic_string<CharT, Traits, Alloc>, CharT>
+    : std::true_type {};
+
+template <class T, class CharT>
+inline constexpr bool is_dynamic_string_v = is_dynamic_string<T, CharT>::value;
+}  // namespace detail
+
+// an argument list that is built up at runtime. strings are copied into an
+// internal arena and user-defined types are copied into it as well (pass
+// std::ref/std::cref to store a reference instead), so the pushed values don't
+// need to outlive the store. clear() keeps all allocated capacity around.
+template <class Context>
+class dynamic_format_arg_store {
+    using char_type = typename Context::char_type;
+
+    struct destructor {
+        void (*destroy)(void*);
+        void* ptr;
+    };
+
+    std::vector<basic_format_arg<Context>> _args;
+    std::vector<detail::named_arg_entry<Context>> _named;
+    std::vector<destructor> _destructors;
+    detail::arena _arena;
+
+    template <class C>
+    friend class basic_format_args;
+
+    template <class T>
+    static basic_string_view<char_type> as_string_view(const T& s) noexcept {
+        if constexpr (std::is_pointer_v<T> || std::is_array_v<T>)
+            return basic_string_view<char_type>(s);
+        else
+            return basic_string_view<char_type>(s.data(), s.size());
+    }
+
+    basic_string_view<char_type> copy_string(basic_string_view<char_type> s) {
+        if (s.empty())
+            return {};
+        auto* p = static_cast<char_type*>(_arena.allocate(
+              s.size() * sizeof(char_type), alignof(char_type)));
+        std::char_traits<char_type>::copy(p, s.data(), s.size());
+        return basic_string_view<char_type>(p, s.size());
+    }
+
+    template <class T>
+    const T& copy_value(const T& v) {
+        T* p = ::new (_arena.allocate(sizeof(T), alignof(T))) T(v);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            try {
+                _destructors.push_back(destructor{
+                      [](void* ptr) { static_cast<T*>(ptr)->~T(); }, p});
+            } catch (...) {
+                p->~T();
+                throw;
+            }
+        }
+        return *p;
+    }
+
+    void destroy_values() noexcept {
+        for (const destructor& d : _destructors)
+            d.destroy(d.ptr);
+        _destructors.clear();
+    }
+
+   public:
+    dynamic_format_arg_store() = default;
+    dynamic_format_arg_store(const dynamic_format_arg_store&) = delete;
+    dynamic_format_arg_store& operator=(const dynamic_format_arg_store&) =
+          delete;
+    ~dynamic_format_arg_store() { destroy_values(); }
+
+    template <class T>
+    void push_back(const T& arg) {
+        using S = decltype(detail::to_storage_type<Context>(arg));
+        if constexpr (detail::is_dynamic_string_v<T, char_type>)
+            _args.push_back(basic_format_arg<Context>(
+                  copy_string(as_string_view(arg))));
+        else if constexpr (std::is_same_v<S, detail::arg_handle<Context>>)
+            _args.push_back(basic_format_arg<Context>(copy_value(arg)));
+        else
+            _args.push_back(basic_format_arg<Context>(arg));
+    }
+    template <class T>
+    void push_back(std::reference_wrapper<T> arg) {
+        using U = std::remove_cv_t<T>;
+        if constexpr (detail::is_dynamic_string_v<U, char_type>)
+            _args.push_back(
+                  basic_format_arg<Context>(as_string_view<U>(arg.get())));
+        else
+            _args.push_back(basic_format_arg<Context>(arg.get()));
+    }
+
+    template <class T>
+    void push_back(const detail::named_arg<char_type, T>& arg) {
+        const auto name = copy_string(arg.name);
+        const auto pos = detail::find_named_arg(
+              _named.data(), _named.data() + _named.size(), name);
+        if (pos != _named.data() + _named.size() && pos->name == name)
+            detail::throw_format_error("duplicate named argument");
+        const auto offset = pos - _named.data();
+        push_back(arg.value);
+        try {
+            _named.insert(_named.begin() + offset,
+                          detail::named_arg_entry<Context>{
+                                name, _args.size() - 1});
+        } catch (...) {
+            _args.pop_back();
+            throw;
+        }
+    }
+
+    void reserve(std::size_t new_cap) { _args.reserve(new_cap); }
+
+    void clear() noexcept {
+        destroy_values();
+        _args.clear();
+        _named.clear();
+        _arena.clear();
+    }
+
+    std::size_t size() const noexcept { return _args.size(); }
+};
+
 namespace detail {
 
 struct parse_integer_result {
@@ -1224,8 +1616,27 @@ struct std_formatter_driver {
         fc.advance_to(out);
         return out;
     }
+
+    // formatted_size only needs to know how wide the value is, not its text
+    constexpr count_iter count_to_spec(
+          basic_format_context<count_iter, CharT>& fc,
+          std::size_t value_width) {
+        LRSTD_ASSERT(spec.has_value());
+        fc.advance_to(fc.out().advance(
+              std::max<std::size_t>(spec->width.integer, value_width)));
+        return fc.out();
+    }
 };
 
+// writes a default engine's value, or just counts it under formatted_size
+template <class Engine, class Out>
+constexpr Out write_default(const Engine& engine, Out out) {
+    if constexpr (std::is_same_v<Out, count_iter>)
+        return out.advance(engine.value_width());
+    else
+        return engine.write_value(out);
+}
+
 struct simple_padding_engine {
     alignment_t align;
 
@@ -1364,6 +1775,7 @@ struct char_default_engine {
     constexpr Out write_value(Out out) const {
         return single_char_writer{}(c, out);
     }
+    static constexpr std::size_t value_width() noexcept { return 1; }
 };
 
 struct char_spec_delegate : integral_spec_verifier<> {
@@ -1432,12 +1844,9 @@ class bool_locale_writer {
    private:
     std::basic_string<CharT> name;
 
-    bool_locale_writer(const std::numpunct<CharT>& np, bool b)
-        : name{b ? np.truename() : np.falsename()} {}
-
    public:
-    bool_locale_writer(const std::locale& loc, bool b)
-        : bool_locale_writer{std::use_facet<std::numpunct<CharT>>(loc), b} {}
+    bool_locale_writer(numpunct_data<CharT> np, bool b)
+        : name{std::move(b ? np.truename : np.falsename)} {}
 
     template <class Writer, class Out>
     Out write(Writer writer, Out out) const {
@@ -1457,7 +1866,8 @@ struct bool_locale_engine_base : bool_default_engine {
                             Context& context)
         : base{b} {
         if (spec.use_locale)
-            locale_writer.emplace(context.locale(), b);
+            locale_writer.emplace(
+                  context_locale(context).template numpunct<CharT>(), b);
     }
 
     template <class Out>
@@ -1495,14 +1905,55 @@ struct bool_spec_engine : bool_locale_engine_base<CharT> {
     }
 };
 
+// one binary digit per bit, plus a sign
 template <class Int>
-using temp_stack_buffer = std::array<char, sizeof(Int) * 8>;
+using temp_stack_buffer = std::array<char, sizeof(Int) * 8 + 1>;
 
 template <class Int>
 using int_template_type = std::conditional_t<std::is_signed_v<Int>,
                                              long long int,
                                              unsigned long long int>;
 
+template <class Int>
+constexpr unsigned long long int magnitude(Int i) noexcept {
+    const auto u = static_cast<unsigned long long int>(i);
+    return i < 0 ? 0 - u : u;
+}
+
+inline constexpr auto powers_of_10 = [] {
+    std::array<unsigned long long int,
+               std::numeric_limits<unsigned long long int>::digits10 + 1>
+          powers{};
+    powers[0] = 1;
+    for (std::size_t i = 1; i != powers.size(); ++i)
+        powers[i] = powers[i - 1] * 10;
+    return powers;
+}();
+
+// the number of digits in n when written in the given base, worked out from
+// its bit width instead of by converting it
+inline constexpr std::size_t count_digits(unsigned long long int n,
+                                          int base) noexcept {
+    n |= 1;  // same digit count, and keeps clz defined for 0
+    const auto bits = static_cast<std::size_t>(
+          std::numeric_limits<unsigned long long int>::digits -
+          __builtin_clzll(n));
+    switch (base) {
+        case 2:
+            return bits;
+        case 8:
+            return (bits + 2) / 3;
+        case 16:
+            return (bits + 3) / 4;
+        default:
+            break;
+    }
+    LRSTD_ASSERT(base == 10);
+    // bits * log10(2), which is at most one less than the digit count
+    const std::size_t guess = bits * 1233 >> 12;
+    return guess + (n >= powers_of_10[guess]);
+}
+
 template <class Int>
 struct integer_default_engine {
     Int i;
@@ -1515,6 +1966,9 @@ struct integer_default_engine {
                                                  result.ptr - buf.data())),
               out);
     }
+    constexpr std::size_t value_width() const noexcept {
+        return count_digits(magnitude(i), 10) + (i < 0);
+    }
 };
 
 struct integer_spec_engine_common {
@@ -1644,12 +2098,9 @@ class integer_locale_writer {
     CharT thousands_sep;
     std::string grouping;
 
-    explicit integer_locale_writer(const std::numpunct<CharT>& np)
-        : thousands_sep{np.thousands_sep()}, grouping{np.grouping()} {}
-
    public:
-    explicit integer_locale_writer(const std::locale& loc)
-        : integer_locale_writer{std::use_facet<std::numpunct<CharT>>(loc)} {}
+    explicit integer_locale_writer(numpunct_data<CharT> np)
+        : thousands_sep{np.thousands_sep}, grouping{std::move(np.grouping)} {}
 
     template <class GenericWriter, class Out>
     Out write(std::string_view s, GenericWriter writer, Out out) const {
@@ -1664,8 +2115,9 @@ class integer_locale_writer {
         return write_first_groups(str, writer, o, std::prev(last_group_it));
     }
 
-    std::size_t get_localized_size(std::string_view str) const {
-        std::size_t size = str.size();
+    // the width of a digits-long number once the separators are added
+    std::size_t get_localized_size(std::size_t digits) const {
+        std::size_t size = digits;
         if (grouping.empty())
             return size;
         const auto last = std::prev(grouping.cend());
@@ -1674,9 +2126,9 @@ class integer_locale_writer {
             if (c <= 0 || c == CHAR_MAX)
                 return size;
             const auto group_size = static_cast<std::size_t>(c);
-            if (group_size >= str.size())
+            if (group_size >= digits)
                 return size;
-            str.remove_prefix(group_size);
+            digits -= group_size;
             ++size;
         }
 
@@ -1684,8 +2136,7 @@ class integer_locale_writer {
         // actual integer division, especially since these strings will always
         // be relatively short
         const auto last_group_size = static_cast<std::size_t>(grouping.back());
-        for (std::size_t i = last_group_size; i < str.size();
-             i += last_group_size)
+        for (std::size_t i = last_group_size; i < digits; i += last_group_size)
             ++size;
 
         return size;
@@ -1723,7 +2174,7 @@ class integer_locale_writer {
         str.remove_prefix(remainder);
         chars_in_last_group -= remainder;
 
-        for (unsigned i = 0; i < chars_in_last_group; i += last_group_size) {
+        for (std::size_t i = 0; i < chars_in_last_group; i += last_group_size) {
             out = writer(thousands_sep, out);
             out = writer(str.substr(0, last_group_size).as_string_view(), out);
             str.remove_prefix(last_group_size);
@@ -1762,12 +2213,13 @@ struct integer_locale_engine_base : integer_spec_engine_base<Int> {
                                Context& context)
         : base{i, spec} {
         if (spec.use_locale)
-            locale_writer.emplace(context.locale());
+            locale_writer.emplace(
+                  context_locale(context).template numpunct<CharT>());
     }
 
     std::size_t value_width() const noexcept {
         return locale_writer
-                     ? locale_writer->get_localized_size(base::buf_str())
+                     ? locale_writer->get_localized_size(base::buf_size)
                      : base::buf_size;
     }
 
@@ -1870,7 +2322,15 @@ struct int_formatter_base : public std_formatter_driver<CharT> {
     template <class Int, typename Out>
     constexpr Out format_impl(Int i, basic_format_context<Out, CharT>& fc) {
         base::finalize_spec(fc, SpecDelegate{});
+        if constexpr (std::is_same_v<Out, count_iter>)
+            return base::count_to_spec(fc, value_width(i, fc));
+        else
+            return write_impl(i, fc);
+    }
 
+   private:
+    template <class Int, typename Out>
+    constexpr Out write_impl(Int i, basic_format_context<Out, CharT>& fc) {
         using T = type_t;
         switch (base::spec->type) {
             case T::c:
@@ -1893,6 +2353,33 @@ struct int_formatter_base : public std_formatter_driver<CharT> {
         return base::format_to_spec(
               fc, integer_simple_spec_engine<Int, CharT>{i, *base::spec, fc});
     }
+
+    template <class Int, class Context>
+    std::size_t value_width(Int i, Context& fc) const {
+        const std_format_spec_base& spec = *base::spec;
+        using T = type_t;
+        switch (spec.type) {
+            case T::c:
+                if (!representable_as_char<CharT>(i)) {
+                    throw_format_error("value not representable as char");
+                }
+                return 1;
+            case T::s:
+                return bool_locale_engine_base<CharT>{static_cast<bool>(i),
+                                                      spec, fc}
+                      .value_width();
+            default:
+                break;
+        }
+        using E = integer_spec_engine_common;
+        std::size_t width = count_digits(magnitude(i), E::get_base(spec.type));
+        if (spec.use_locale)
+            width = integer_locale_writer<CharT>{
+                  context_locale(fc).template numpunct<CharT>()}
+                          .get_localized_size(width);
+        return width + E::get_prefix(spec.type, spec.alternate).size() +
+               (E::get_sign_char(spec.sign, i < 0) != '\0');
+    }
 };
 
 template <class Int, class CharT, class SpecDelegate, class DefaultEngine>
@@ -1901,7 +2388,7 @@ struct int_formatter : public int_formatter_base<CharT, SpecDelegate> {
     template <typename Out>
     constexpr Out format(Int i, basic_format_context<Out, CharT>& fc) {
         if (!base::spec) {
-            fc.advance_to(DefaultEngine{i}.write_value(fc.out()));
+            fc.advance_to(write_default(DefaultEngine{i}, fc.out()));
             return fc.out();
         }
         return base::format_impl(static_cast<int_template_type<Int>>(i), fc);
@@ -2048,6 +2535,10 @@ struct ptr_spec_delegate {
     }
 };
 
+inline std::size_t ptr_width(const void* ptr) noexcept {
+    return 2 + count_digits(reinterpret_cast<std::uintptr_t>(ptr), 16);
+}
+
 struct ptr_default_engine {
     const void* ptr;
     std::array<char, sizeof(void*) * 2 + 2> buf;
@@ -2095,13 +2586,22 @@ struct pointer_formatter : public std_formatter_driver<CharT> {
     constexpr typename basic_format_context<Out, CharT>::iterator format(
           Pointer p,
           basic_format_context<Out, CharT>& fc) {
-        if (!base::spec) {
-            fc.advance_to(ptr_default_engine{p}.write_value(fc.out()));
+        if constexpr (std::is_same_v<Out, count_iter>) {
+            if (!base::spec) {
+                fc.advance_to(fc.out().advance(ptr_width(p)));
+                return fc.out();
+            }
+            base::finalize_spec(fc, ptr_spec_delegate{});
+            return base::count_to_spec(fc, ptr_width(p));
+        } else {
+            if (!base::spec) {
+                fc.advance_to(ptr_default_engine{p}.write_value(fc.out()));
+                return fc.out();
+            }
+            base::finalize_spec(fc, ptr_spec_delegate{});
+            fc.advance_to(base::format_to_spec(fc, ptr_spec_engine{{p}}));
             return fc.out();
         }
-        base::finalize_spec(fc, ptr_spec_delegate{});
-        fc.advance_to(base::format_to_spec(fc, ptr_spec_engine{{p}}));
-        return fc.out();
     }
 };
 template <class CharT>
@@ -2140,7 +2640,7 @@ struct str_default_engine {
     std::basic_string_view<CharT, Traits> str;
     template <class Out>
     constexpr Out write_value(Out out) const {
-        return overlapping_str_writer{}(str, out);
+        return stable_str_writer{}(str, out);
     }
 };
 
@@ -2239,38 +2739,49 @@ struct fmt_str_parser {
 
     template <class Callbacks>
     constexpr void parse(Callbacks cb) {
+        while (!pc._rng.empty() && !cb.done())
+            parse_next(cb);
+    }
+
+    // parses and outputs one piece of what's left of the format string: a
+    // run of literal text, an escaped brace, or a replacement field. pc is
+    // left just past it, so parsing can stop between any two pieces and
+    // pick up again later.
+    template <class Callbacks>
+    constexpr void parse_next(Callbacks cb) {
         range<CharT>& fmt = pc._rng;
-        while (!fmt.empty()) {
-            const auto lbrace_it = fmt.find('{');
-            if (lbrace_it == fmt.end())
-                return write_text(cb, fmt);
-            auto next = lbrace_it + 1;
-            if (next == fmt.end())
-                return cb.error();
-            if (*next != '{') {
-                write_text(cb, range<CharT>{fmt.begin(), lbrace_it});
-                fmt.advance_to(next);
-                parse_replacement_field(cb);
-            } else {
-                write_text(cb, range<CharT>{fmt.begin(), next});
-                fmt.advance_to(next + 1);
-            }
+        LRSTD_ASSERT(!fmt.empty());
+        const auto lbrace_it = fmt.find('{');
+        if (lbrace_it != fmt.begin())
+            return parse_text(cb, range<CharT>{fmt.begin(), lbrace_it});
+        const auto next = lbrace_it + 1;
+        if (next == fmt.end())
+            return cb.error();
+        if (*next == '{') {
+            cb.text(range<CharT>{lbrace_it, next});
+            fmt.advance_to(next + 1);
+            return;
         }
+        fmt.advance_to(next);
+        parse_replacement_field(cb);
     }
 
    private:
+    // text is a prefix of the format string without any '{'. outputs it up
+    // to and including the first escaped '}'.
     template <class Callbacks>
-    static constexpr void write_text(Callbacks cb, range<CharT> text) {
-        while (!text.empty()) {
-            auto rbrace_it = text.find('}');
-            if (rbrace_it == text.end())
-                return cb.text(text);
-            ++rbrace_it;
-            if (rbrace_it == text.end() || *rbrace_it != '}')
-                return cb.error();
-            cb.text(range<CharT>{text.begin(), rbrace_it});
-            text.advance_to(++rbrace_it);
+    constexpr void parse_text(Callbacks cb, range<CharT> text) {
+        auto rbrace_it = text.find('}');
+        if (rbrace_it == text.end()) {
+            cb.text(text);
+            pc._rng.advance_to(text.end());
+            return;
         }
+        ++rbrace_it;
+        if (rbrace_it == text.end() || *rbrace_it != '}')
+            return cb.error();
+        cb.text(range<CharT>{text.begin(), rbrace_it});
+        pc._rng.advance_to(rbrace_it + 1);
     }
 
     constexpr parse_integer_result parse_arg_id() {
@@ -2281,6 +2792,24 @@ struct fmt_str_parser {
         return parse_integer(fmt);
     }
 
+    static constexpr bool is_name_start(CharT c) noexcept {
+        return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
+    }
+    static constexpr bool is_name_char(CharT c) noexcept {
+        return is_name_start(c) || ('0' <= c && c <= '9');
+    }
+
+    constexpr basic_string_view<CharT> parse_arg_name() {
+        range<CharT>& fmt = pc._rng;
+        LRSTD_ASSERT(!fmt.empty() && is_name_start(fmt.front()));
+        auto it = fmt.begin() + 1;
+        for (; it != fmt.end() && is_name_char(*it); ++it)
+            ;
+        const range<CharT> name{fmt.begin(), it};
+        fmt.advance_to(it);
+        return name.as_string_view();
+    }
+
     template <class Callbacks>
     constexpr void parse_replacement_field(Callbacks cb) {
         range<CharT>& fmt = pc._rng;
@@ -2292,6 +2821,11 @@ struct fmt_str_parser {
         }
         if (fmt.consume(':')) {
             cb.replacement_field(pc.next_arg_id());
+        } else if (is_name_start(fmt.front())) {
+            const basic_string_view<CharT> name = parse_arg_name();
+            if (!fmt.consume(':') && !fmt.match('}'))
+                return cb.error();
+            cb.replacement_field(cb.named_arg_id(name));
         } else {
             const parse_integer_result arg_value = parse_arg_id();
             if (arg_value.tag == parse_integer_result::type::error)
@@ -2333,8 +2867,14 @@ struct arg_out_func : throw_uninitialized_format_arg {
     constexpr void operator()(unsigned int ui) const {
         return impl(static_cast<unsigned long long>(ui));
     }
+    // string arguments outlive the call, unlike whatever strings a custom
+    // formatter might pass on to formatter<string_view>
+    constexpr void operator()(basic_string_view<CharT> sv) const {
+        const stable_text_scope<typename Context::iterator> scope(fc.out());
+        impl(sv);
+    }
     constexpr void operator()(const CharT* cptr) const {
-        return impl(basic_string_view<CharT>(cptr));
+        return (*this)(basic_string_view<CharT>(cptr));
     }
 
     constexpr void operator()(
@@ -2353,33 +2893,76 @@ constexpr void arg_out(Context& fc,
     visit_format_arg(arg_out_func<Context, CharT>{{}, fc, pc}, arg);
 }
 
-template <class CharT, class Out>
-LRSTD_EXTRA_CONSTEXPR Out
-vformat_to_core(basic_format_context<Out, CharT>& context,
-                basic_string_view<CharT> fmt) {
-    basic_format_parse_context<CharT> parse_context(fmt, context.args_size());
+template <class Context, class S, bool IsSmall>
+LRSTD_EXTRA_CONSTEXPR void dispatch_arg(
+      const void* data,
+      std::size_t i,
+      Context& fc,
+      basic_format_parse_context<typename Context::char_type>& pc) {
+    using CharT = typename Context::char_type;
+    const arg_storage<Context>* storage;
+    if constexpr (IsSmall)
+        storage = &reinterpret_cast<const arg_storage<Context>*>(data)[i];
+    else
+        storage = &reinterpret_cast<const basic_format_arg<Context>*>(data)[i]
+                         .value;
+    arg_out_func<Context, CharT>{{}, fc, pc}(get_storage<S>(*storage));
+}
+
+// formats what's left of the format string in parse_context, a piece at a
+// time, until it's used up or done() asks to stop. parse_context keeps its
+// place, so a later call carries on from there.
+template <class CharT, class Out, class Done>
+LRSTD_EXTRA_CONSTEXPR void format_pieces(
+      basic_format_context<Out, CharT>& context,
+      basic_format_parse_context<CharT>& parse_context,
+      Done done) {
+    const std::size_t args_size = context.args_size();
     struct Callbacks {
         constexpr void text(range<CharT> range) const {
-            context.advance_to(overlapping_str_writer{}(range.as_string_view(),
-                                                        context.out()));
+            const stable_text_scope<Out> scope(context.out());
+            context.advance_to(
+                  stable_str_writer{}(range.as_string_view(), context.out()));
         }
         constexpr void replacement_field(std::size_t arg_id) const {
-            arg_out(context, parse_context, context.arg(arg_id));
+            if (!context.dispatch_arg(arg_id, args_size, parse_context))
+                arg_out(context, parse_context, context.arg(arg_id));
+        }
+        constexpr std::size_t named_arg_id(
+              basic_string_view<CharT> name) const {
+            return context.arg_id(name);
         }
         [[noreturn]] void error() {
             throw_format_error("invalid format string");
         }
+        constexpr bool done() const { return done_fn(); }
         basic_format_context<Out, CharT>& context;
         basic_format_parse_context<CharT>& parse_context;
+        std::size_t args_size;
+        Done& done_fn;
     };
     fmt_str_parser<CharT>{parse_context}.parse(
-          Callbacks{context, parse_context});
+          Callbacks{context, parse_context, args_size, done});
+}
+
+template <class CharT, class Out>
+LRSTD_EXTRA_CONSTEXPR Out
+vformat_to_core(basic_format_context<Out, CharT>& context,
+                basic_string_view<CharT> fmt) {
+    basic_format_parse_context<CharT> parse_context(fmt, context.args_size());
+    // output that is cut short doesn't need the rest of the string
+    lrstd::detail::format_pieces(context, parse_context, [&] {
+        if constexpr (is_truncating_iter<Out>::value)
+            return context.out().truncated();
+        else
+            return false;
+    });
     return context.out();
 }
 
 template <class CharT, class Out>
 LRSTD_EXTRA_CONSTEXPR Out vformat_to_impl(Out out,
-                                          const std::locale& loc,
+                                          locale_ref loc,
                                           basic_string_view<CharT> fmt_sv,
                                           format_args_t<Out, CharT>& args) {
     basic_format_context<Out, CharT> context(args, out, loc);
@@ -2393,42 +2976,284 @@ LRSTD_EXTRA_CONSTEXPR Out vformat_to_impl(Out out,
     return lrstd::detail::vformat_to_core(context, fmt_sv);
 }
 
+// runs format_into on a scratch buffer and returns what it wrote
+template <class CharT, class FormatInto>
+std::basic_string<CharT> format_to_string(FormatInto format_into) {
+#if LRSTD_USE_THREAD_LOCAL_BUFFER
+    typename thread_local_buffer<CharT>::lease lease(
+          thread_local_buffer<CharT>::for_strings());
+    if (basic_memory_buffer<CharT>* buf = lease.get()) {
+        format_into(*buf);
+        return std::basic_string<CharT>(buf->data(), buf->size());
+    }
+#endif
+    basic_memory_buffer<CharT> buf;
+    format_into(buf);
+    return std::basic_string<CharT>(buf.data(), buf.size());
+}
+
+// runs format_into on the thread-local buffer and returns a view of it
+template <class CharT, class FormatInto>
+basic_string_view<CharT> format_to_thread_local(FormatInto format_into) {
+    typename thread_local_buffer<CharT>::lease lease(
+          thread_local_buffer<CharT>::for_views());
+    basic_memory_buffer<CharT>* const buf = lease.get();
+    if (!buf)
+        throw_format_error("format_view called while formatting a view");
+    format_into(*buf);
+    return {buf->data(), buf->size()};
+}
+
 template <class CharT>
 LRSTD_EXTRA_CONSTEXPR std::basic_string<CharT> vformat_impl(
-      const std::locale& loc,
+      locale_ref loc,
       basic_string_view<CharT> fmt,
-      format_args_t<build_buf_iter<CharT>, CharT> args) {
-    std::basic_string<CharT> ret;
-    lrstd::detail::vformat_to_impl(build_buf_iter(ret), loc, fmt, args);
-    return ret;
+      format_args_t<buffer_iter<CharT>, CharT> args) {
+    return format_to_string<CharT>([&](buffer<CharT>& buf) {
+        lrstd::detail::vformat_to_impl(buffer_iter<CharT>(buf), loc, fmt,
+                                       args);
+    });
 }
 template <class CharT>
 LRSTD_EXTRA_CONSTEXPR std::basic_string<CharT> vformat_impl(
       basic_string_view<CharT> fmt,
-      format_args_t<build_buf_iter<CharT>, CharT> args) {
-    std::basic_string<CharT> ret;
-    lrstd::detail::vformat_to_impl(build_buf_iter(ret), fmt, args);
-    return ret;
+      format_args_t<buffer_iter<CharT>, CharT> args) {
+    return format_to_string<CharT>([&](buffer<CharT>& buf) {
+        lrstd::detail::vformat_to_impl(buffer_iter<CharT>(buf), fmt, args);
+    });
 }
 
-}  // namespace detail
+template <class T, class = void>
+struct is_allocator : std::false_type {};
+template <class T>
+struct is_allocator<T,
+                    std::void_t<typename T::value_type,
+                                decltype(std::declval<T&>().allocate(
+                                      std::size_t{}))>> : std::true_type {};
+
+// enables the allocator overloads for an allocator of CharT
+template <class Alloc, class CharT>
+using enable_if_char_allocator_t = std::enable_if_t<
+      std::conjunction_v<is_allocator<Alloc>,
+                         std::is_same<typename Alloc::value_type, CharT>>>;
+
+template <class Alloc>
+using string_for_allocator =
+      std::basic_string<typename Alloc::value_type,
+                        std::char_traits<typename Alloc::value_type>,
+                        Alloc>;
+
+// formatting with an allocator: the spill-over storage of the scratch buffer
+// and the result string both come from it
+template <class CharT, class Alloc>
+std::basic_string<CharT, std::char_traits<CharT>, Alloc> vformat_impl(
+      const Alloc& alloc,
+      locale_ref loc,
+      basic_string_view<CharT> fmt,
+      format_args_t<buffer_iter<CharT>, CharT> args) {
+    basic_memory_buffer<CharT, inline_buffer_size, Alloc> buf(alloc);
+    lrstd::detail::vformat_to_impl(buffer_iter<CharT>(buf), loc, fmt, args);
+    return {buf.data(), buf.size(), alloc};
+}
+template <class CharT, class Alloc>
+std::basic_string<CharT, std::char_traits<CharT>, Alloc> vformat_impl(
+      const Alloc& alloc,
+      basic_string_view<CharT> fmt,
+      format_args_t<buffer_iter<CharT>, CharT> args) {
+    basic_memory_buffer<CharT, inline_buffer_size, Alloc> buf(alloc);
+    lrstd::detail::vformat_to_impl(buffer_iter<CharT>(buf), fmt, args);
+    return {buf.data(), buf.size(), alloc};
+}
 
-template <class Out>
-LRSTD_EXTRA_CONSTEXPR Out vformat_to(Out out,
-                                     const std::locale& loc,
-                                     std::string_view fmt,
-                                     format_args_t<Out, char> args) {
-    return detail::vformat_to_impl(out, loc, fmt, args);
+template <class CharT>
+basic_string_view<CharT> vformat_view_impl(
+      locale_ref loc,
+      basic_string_view<CharT> fmt,
+      format_args_t<buffer_iter<CharT>, CharT> args) {
+    return format_to_thread_local<CharT>([&](buffer<CharT>& buf) {
+        lrstd::detail::vformat_to_impl(buffer_iter<CharT>(buf), loc, fmt,
+                                       args);
+    });
+}
+template <class CharT>
+basic_string_view<CharT> vformat_view_impl(
+      basic_string_view<CharT> fmt,
+      format_args_t<buffer_iter<CharT>, CharT> args) {
+    return format_to_thread_local<CharT>([&](buffer<CharT>& buf) {
+        lrstd::detail::vformat_to_impl(buffer_iter<CharT>(buf), fmt, args);
+    });
 }
 
-template <class Out>
-LRSTD_EXTRA_CONSTEXPR Out vformat_to(Out out,
-                                     const std::locale& loc,
-                                     std::wstring_view fmt,
-                                     format_args_t<Out, wchar_t> args) {
-    return detail::vformat_to_impl(out, loc, fmt, args);
+// a rough guess at how long the output of formatting args with fmt will
+// be: all of fmt, plus the longest each argument can be without a width or
+// precision. it's only used to size a destination up front.
+struct max_width_visitor {
+    template <class T>
+    constexpr std::size_t operator()(const T& t) const noexcept {
+        if constexpr (std::is_same_v<T, bool>) {
+            return 5;
+        } else if constexpr (is_char_or_wchar_v<T>) {
+            return 1;
+        } else if constexpr (std::is_integral_v<T>) {
+            return std::numeric_limits<T>::digits10 + 2;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            return std::numeric_limits<T>::max_digits10 + 8;
+        } else if constexpr (std::is_same_v<T, const void*>) {
+            return sizeof(void*) * 2 + 2;
+        } else if constexpr (std::is_pointer_v<T>) {
+            using CharT = std::remove_cv_t<std::remove_pointer_t<T>>;
+            return std::char_traits<CharT>::length(t);
+        } else if constexpr (std::is_same_v<T, std::string_view> ||
+                             std::is_same_v<T, std::wstring_view>) {
+            return t.size();
+        } else {
+            return 0;
+        }
+    }
+};
+
+template <class CharT, class Context>
+std::size_t estimate_formatted_size(basic_string_view<CharT> fmt,
+                                    const basic_format_args<Context>& args) {
+    std::size_t size = fmt.size();
+    const std::size_t args_size = args._get_size();
+    for (std::size_t i = 0; i != args_size; ++i)
+        size += lrstd::visit_format_arg(max_width_visitor{}, args.get(i));
+    return size;
+}
+
+template <class CharT, class Traits, class Alloc>
+void vformat_append_impl(std::basic_string<CharT, Traits, Alloc>& str,
+                         locale_ref loc,
+                         basic_string_view<CharT> fmt,
+                         format_args_t<buffer_iter<CharT>, CharT> args) {
+    string_append_buffer<std::basic_string<CharT, Traits, Alloc>> buf(
+          str, estimate_formatted_size(fmt, args));
+    lrstd::detail::vformat_to_impl(buffer_iter<CharT>(buf), loc, fmt, args);
+    buf.commit();
+}
+template <class CharT, class Traits, class Alloc>
+void vformat_append_impl(std::basic_string<CharT, Traits, Alloc>& str,
+                         basic_string_view<CharT> fmt,
+                         format_args_t<buffer_iter<CharT>, CharT> args) {
+    string_append_buffer<std::basic_string<CharT, Traits, Alloc>> buf(
+          str, estimate_formatted_size(fmt, args));
+    lrstd::detail::vformat_to_impl(buffer_iter<CharT>(buf), fmt, args);
+    buf.commit();
+}
+
+// outside of constant evaluation, format_to and the like format through a
+// buffer_iter<CharT>, with a buffer in front of the caller's output, so the
+// formatters are instantiated once per character type rather than once per
+// output type. the buffers can't be used in constant expressions, so with
+// LRSTD_USE_EXTRA_CONSTEXPR each output keeps a context of its own.
+#if LRSTD_USE_EXTRA_CONSTEXPR
+inline constexpr bool erase_outputs = false;
+#else
+inline constexpr bool erase_outputs = true;
+#endif
+
+struct never_done {
+    constexpr bool operator()() const noexcept { return false; }
+};
+
+// for a buffer with an output_limit: stops once anything went past it
+template <class CharT>
+struct limit_reached {
+    const output_limit& limit;
+    const buffer<CharT>& buf;
+    bool operator()() const noexcept {
+        return limit.count + buf.size() > limit.limit;
+    }
+};
+
+template <class CharT, class Done>
+void vformat_to_buffer(buffer<CharT>& buf,
+                       locale_ref loc,
+                       basic_string_view<CharT> fmt,
+                       format_args_t<buffer_iter<CharT>, CharT> args,
+                       Done done) {
+    using Context = basic_format_context<buffer_iter<CharT>, CharT>;
+    Context context(args, buffer_iter<CharT>(buf), loc);
+    basic_format_parse_context<CharT> parse_context(fmt, context.args_size());
+    lrstd::detail::format_pieces(context, parse_context, done);
+}
+
+// format_to for any output through the matching buffer
+template <class CharT, class Out>
+Out vformat_to_erased(Out out,
+                      locale_ref loc,
+                      basic_string_view<CharT> fmt,
+                      format_args_t<buffer_iter<CharT>, CharT> args) {
+    if constexpr (std::is_same_v<Out, CharT*>) {
+        pointer_buffer<CharT> buf(out);
+        vformat_to_buffer(buf, loc, fmt, args, never_done{});
+        return out + buf.size();
+    } else if constexpr (is_back_inserter_for<Out, CharT>::value) {
+        auto& container = get_container(out);
+        string_append_buffer<std::remove_reference_t<decltype(container)>> buf(
+              container, estimate_formatted_size(fmt, args));
+        vformat_to_buffer(buf, loc, fmt, args, never_done{});
+        buf.commit();
+        return out;
+    } else {
+        iterator_buffer<Out, CharT> buf(out);
+        vformat_to_buffer(buf, loc, fmt, args, never_done{});
+        return buf.out();
+    }
+}
+
+template <class CharT, class... Args>
+auto make_buffer_format_args(const Args&... args) {
+    return make_format_args<basic_format_context<buffer_iter<CharT>, CharT>>(
+          args...);
 }
 
+template <class CharT, class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR Out format_to_impl(Out out,
+                                         locale_ref loc,
+                                         basic_string_view<CharT> fmt,
+                                         const Args&... args) {
+    if constexpr (is_lowerable_iterator_v<Out>) {
+        return to_iter(
+              format_to_impl(to_raw_pointer(out), loc, fmt, args...), out);
+    } else if constexpr (erase_outputs && !has_own_context_v<Out>) {
+        return vformat_to_erased(out, loc, fmt,
+                                 {make_buffer_format_args<CharT>(args...)});
+    } else if constexpr (!is_direct_output_v<Out>) {
+        iterator_buffer<Out, CharT> buf(out);
+        format_to_impl(buffer_iter<CharT>(buf), loc, fmt, args...);
+        return buf.out();
+    } else {
+        using Context = basic_format_context<Out, CharT>;
+        const auto store = make_format_args<Context>(args...);
+        format_args_t<Out, CharT> format_args(store);
+        return vformat_to_impl(out, loc, fmt, format_args);
+    }
+}
+template <class CharT, class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR Out format_to_impl(Out out,
+                                         basic_string_view<CharT> fmt,
+                                         const Args&... args) {
+    if constexpr (is_lowerable_iterator_v<Out>) {
+        return to_iter(format_to_impl(to_raw_pointer(out), fmt, args...), out);
+    } else if constexpr (erase_outputs && !has_own_context_v<Out>) {
+        return vformat_to_erased(out, locale_ref{}, fmt,
+                                 {make_buffer_format_args<CharT>(args...)});
+    } else if constexpr (!is_direct_output_v<Out>) {
+        iterator_buffer<Out, CharT> buf(out);
+        format_to_impl(buffer_iter<CharT>(buf), fmt, args...);
+        return buf.out();
+    } else {
+        using Context = basic_format_context<Out, CharT>;
+        const auto store = make_format_args<Context>(args...);
+        format_args_t<Out, CharT> format_args(store);
+        return vformat_to_impl(out, fmt, format_args);
+    }
+}
+
+}  // namespace detail
+
 template <class Out>
 LRSTD_EXTRA_CONSTEXPR Out vformat_to(Out out,
                                      std::string_view fmt,
@@ -2445,69 +3270,68 @@ LRSTD_EXTRA_CONSTEXPR Out vformat_to(Out out,
 
 template <class Out, class... Args>
 LRSTD_EXTRA_CONSTEXPR Out format_to(Out out,
-                                    const std::locale& loc,
                                     std::string_view fmt,
                                     const Args&... args) {
-    using Context = basic_format_context<Out, std::string_view::value_type>;
-    return lrstd::vformat_to(out, loc, fmt,
-                             {make_format_args<Context>(args...)});
+    return detail::format_to_impl(out, fmt, args...);
 }
 
 template <class Out, class... Args>
 LRSTD_EXTRA_CONSTEXPR Out format_to(Out out,
-                                    const std::locale& loc,
                                     std::wstring_view fmt,
                                     const Args&... args) {
-    using Context = basic_format_context<Out, std::wstring_view::value_type>;
-    return lrstd::vformat_to(out, loc, fmt,
-                             {make_format_args<Context>(args...)});
+    return detail::format_to_impl(out, fmt, args...);
 }
 
-template <class Out, class... Args>
-LRSTD_EXTRA_CONSTEXPR Out format_to(Out out,
-                                    std::string_view fmt,
-                                    const Args&... args) {
-    using Context = basic_format_context<Out, std::string_view::value_type>;
-    return lrstd::vformat_to(out, fmt, {make_format_args<Context>(args...)});
+inline std::string vformat(std::string_view fmt, format_args args) {
+    return detail::vformat_impl(fmt, args);
+}
+inline std::wstring vformat(std::wstring_view fmt, wformat_args args) {
+    return detail::vformat_impl(fmt, args);
 }
 
-template <class Out, class... Args>
-LRSTD_EXTRA_CONSTEXPR Out format_to(Out out,
-                                    std::wstring_view fmt,
-                                    const Args&... args) {
-    using Context = basic_format_context<Out, std::wstring_view::value_type>;
-    return lrstd::vformat_to(out, fmt, {make_format_args<Context>(args...)});
+// vformat/format, but the result is a view into a per-thread buffer. it stays
+// valid until the next vformat_view or format_view on the same thread.
+inline std::string_view vformat_view(std::string_view fmt, format_args args) {
+    return detail::vformat_view_impl(fmt, args);
+}
+inline std::wstring_view vformat_view(std::wstring_view fmt,
+                                      wformat_args args) {
+    return detail::vformat_view_impl(fmt, args);
 }
 
-inline std::string vformat(const std::locale& loc,
-                           std::string_view fmt,
-                           format_args args) {
-    return detail::vformat_impl(loc, fmt, args);
+template <class... Args>
+std::string_view format_view(std::string_view fmt, const Args&... args) {
+    return lrstd::vformat_view(fmt, {make_format_args(args...)});
 }
-inline std::wstring vformat(const std::locale& loc,
-                            std::wstring_view fmt,
-                            wformat_args args) {
-    return detail::vformat_impl(loc, fmt, args);
+template <class... Args>
+std::wstring_view format_view(std::wstring_view fmt, const Args&... args) {
+    return lrstd::vformat_view(fmt, {make_wformat_args(args...)});
 }
-inline std::string vformat(std::string_view fmt, format_args args) {
-    return detail::vformat_impl(fmt, args);
+
+// vformat/format, but appending to an existing string and reusing its
+// capacity
+inline void vformat_append(std::string& str,
+                           std::string_view fmt,
+                           format_args args) {
+    detail::vformat_append_impl(str, fmt, args);
 }
-inline std::wstring vformat(std::wstring_view fmt, wformat_args args) {
-    return detail::vformat_impl(fmt, args);
+inline void vformat_append(std::wstring& str,
+                           std::wstring_view fmt,
+                           wformat_args args) {
+    detail::vformat_append_impl(str, fmt, args);
 }
 
 template <class... Args>
-std::string format(const std::locale& loc,
+void format_append(std::string& str,
                    std::string_view fmt,
                    const Args&... args) {
-    return lrstd::vformat(loc, fmt, {make_format_args(args...)});
+    lrstd::vformat_append(str, fmt, {make_format_args(args...)});
 }
-
 template <class... Args>
-std::wstring format(const std::locale& loc,
-                    std::wstring_view fmt,
-                    const Args&... args) {
-    return lrstd::vformat(loc, fmt, {make_wformat_args(args...)});
+void format_append(std::wstring& str,
+                   std::wstring_view fmt,
+                   const Args&... args) {
+    lrstd::vformat_append(str, fmt, {make_wformat_args(args...)});
 }
 
 template <class... Args>
@@ -2520,26 +3344,38 @@ std::wstring format(std::wstring_view fmt, const Args&... args) {
     return lrstd::vformat(fmt, {make_wformat_args(args...)});
 }
 
-template <class... Args>
-LRSTD_EXTRA_CONSTEXPR std::size_t formatted_size(const std::locale& loc,
-                                                 std::string_view fmt,
-                                                 const Args&... args) {
-    using Context = basic_format_context<detail::count_iter,
-                                         std::string_view::value_type>;
-    return lrstd::vformat_to(detail::count_iter{}, loc, fmt,
-                             {make_format_args<Context>(args...)})
-          .count();
+// vformat/format with the result string, and any memory used along the way,
+// coming from alloc
+template <class Alloc,
+          class = detail::enable_if_char_allocator_t<Alloc, char>>
+detail::string_for_allocator<Alloc> vformat(const Alloc& alloc,
+                                            std::string_view fmt,
+                                            format_args args) {
+    return detail::vformat_impl(alloc, fmt, args);
+}
+template <class Alloc,
+          class = detail::enable_if_char_allocator_t<Alloc, wchar_t>>
+detail::string_for_allocator<Alloc> vformat(const Alloc& alloc,
+                                            std::wstring_view fmt,
+                                            wformat_args args) {
+    return detail::vformat_impl(alloc, fmt, args);
 }
 
-template <class... Args>
-LRSTD_EXTRA_CONSTEXPR std::size_t formatted_size(const std::locale& loc,
-                                                 std::wstring_view fmt,
-                                                 const Args&... args) {
-    using Context = basic_format_context<detail::count_iter,
-                                         std::wstring_view::value_type>;
-    return lrstd::vformat_to(detail::count_iter{}, loc, fmt,
-                             {make_format_args<Context>(args...)})
-          .count();
+template <class Alloc,
+          class... Args,
+          class = detail::enable_if_char_allocator_t<Alloc, char>>
+detail::string_for_allocator<Alloc> format(const Alloc& alloc,
+                                           std::string_view fmt,
+                                           const Args&... args) {
+    return lrstd::vformat(alloc, fmt, {make_format_args(args...)});
+}
+template <class Alloc,
+          class... Args,
+          class = detail::enable_if_char_allocator_t<Alloc, wchar_t>>
+detail::string_for_allocator<Alloc> format(const Alloc& alloc,
+                                           std::wstring_view fmt,
+                                           const Args&... args) {
+    return lrstd::vformat(alloc, fmt, {make_wformat_args(args...)});
 }
 
 template <class... Args>
@@ -2568,52 +3404,677 @@ struct format_to_n_result {
     iter_difference_t<Out> size;
 };
 
+namespace detail {
+template <class Out>
+constexpr std::size_t truncation_limit(iter_difference_t<Out> n) noexcept {
+    return n > 0 ? static_cast<std::size_t>(n) : 0;
+}
+
+// format_to_n and format_to_truncated for any output, through a buffer that
+// only lets the first n characters through. with StopAtLimit formatting
+// stops as soon as they're exceeded. returns the output and the size of
+// everything that was formatted.
+template <bool StopAtLimit, class CharT, class Out>
+std::pair<Out, std::size_t> vformat_to_n_erased(
+      Out out,
+      iter_difference_t<Out> n,
+      locale_ref loc,
+      basic_string_view<CharT> fmt,
+      format_args_t<buffer_iter<CharT>, CharT> args) {
+    const auto format = [&](buffer<CharT>& buf, const output_limit& limit) {
+        if constexpr (StopAtLimit)
+            vformat_to_buffer(buf, loc, fmt, args,
+                              limit_reached<CharT>{limit, buf});
+        else
+            vformat_to_buffer(buf, loc, fmt, args, never_done{});
+    };
+    output_limit limit{truncation_limit<Out>(n)};
+    if constexpr (std::is_same_v<Out, CharT*>) {
+        limited_pointer_buffer<CharT> buf(out, limit);
+        format(buf, limit);
+        return {buf.out(), limit.count + buf.size()};
+    } else {
+        limited_iterator_buffer<Out, CharT> buf(out, limit);
+        format(buf, limit);
+        out = buf.out();
+        return {out, limit.count};
+    }
+}
+
+template <class CharT, class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR format_to_n_result<Out> format_to_n_impl(
+      Out out,
+      iter_difference_t<Out> n,
+      locale_ref loc,
+      basic_string_view<CharT> fmt,
+      const Args&... args) {
+    if constexpr (is_lowerable_iterator_v<Out>) {
+        const auto result =
+              format_to_n_impl(to_raw_pointer(out), n, loc, fmt, args...);
+        return format_to_n_result<Out>{to_iter(result.out, out), result.size};
+    } else if constexpr (erase_outputs && !has_own_context_v<Out>) {
+        const auto [end, size] = vformat_to_n_erased<false>(
+              out, n, loc, fmt, {make_buffer_format_args<CharT>(args...)});
+        return {end, static_cast<iter_difference_t<Out>>(size)};
+    } else if constexpr (!is_direct_output_v<Out>) {
+        iterator_buffer<Out, CharT> buf(out);
+        const auto result = format_to_impl(
+              write_n_iter<buffer_iter<CharT>>{n, buffer_iter<CharT>(buf)},
+              loc, fmt, args...);
+        return format_to_n_result<Out>{buf.out(), result.count()};
+    } else {
+        const auto result =
+              format_to_impl(write_n_iter<Out>{n, out}, loc, fmt, args...);
+        return format_to_n_result<Out>{result.iter(), result.count()};
+    }
+}
+template <class CharT, class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR format_to_n_result<Out> format_to_n_impl(
+      Out out,
+      iter_difference_t<Out> n,
+      basic_string_view<CharT> fmt,
+      const Args&... args) {
+    if constexpr (is_lowerable_iterator_v<Out>) {
+        const auto result =
+              format_to_n_impl(to_raw_pointer(out), n, fmt, args...);
+        return format_to_n_result<Out>{to_iter(result.out, out), result.size};
+    } else if constexpr (erase_outputs && !has_own_context_v<Out>) {
+        const auto [end, size] = vformat_to_n_erased<false>(
+              out, n, locale_ref{}, fmt,
+              {make_buffer_format_args<CharT>(args...)});
+        return {end, static_cast<iter_difference_t<Out>>(size)};
+    } else if constexpr (!is_direct_output_v<Out>) {
+        iterator_buffer<Out, CharT> buf(out);
+        const auto result = format_to_impl(
+              write_n_iter<buffer_iter<CharT>>{n, buffer_iter<CharT>(buf)},
+              fmt, args...);
+        return format_to_n_result<Out>{buf.out(), result.count()};
+    } else {
+        const auto result =
+              format_to_impl(write_n_iter<Out>{n, out}, fmt, args...);
+        return format_to_n_result<Out>{result.iter(), result.count()};
+    }
+}
+}  // namespace detail
+
 template <class Out, class... Args>
 LRSTD_EXTRA_CONSTEXPR format_to_n_result<Out> format_to_n(
       Out out,
       iter_difference_t<Out> n,
-      const std::locale& loc,
       std::string_view fmt,
       const Args&... args) {
-    auto result = lrstd::format_to(detail::write_n_iter<Out>{n, out}, loc, fmt,
-                                   args...);
-    return format_to_n_result<Out>{result.iter(), result.count()};
+    return detail::format_to_n_impl(out, n, fmt, args...);
 }
 
 template <class Out, class... Args>
 LRSTD_EXTRA_CONSTEXPR format_to_n_result<Out> format_to_n(
       Out out,
       iter_difference_t<Out> n,
-      const std::locale& loc,
       std::wstring_view fmt,
       const Args&... args) {
-    auto result = lrstd::format_to(detail::write_n_iter<Out>{n, out}, loc, fmt,
-                                   args...);
-    return format_to_n_result<Out>{result.iter(), result.count()};
+    return detail::format_to_n_impl(out, n, fmt, args...);
+}
+
+// like format_to_n, but stops formatting as soon as the output is cut off,
+// so the full size is never known
+template <class Out>
+struct format_to_truncated_result {
+    Out out;
+    bool truncated;
+};
+
+namespace detail {
+template <class CharT, class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR format_to_truncated_result<Out> format_to_truncated_impl(
+      Out out,
+      iter_difference_t<Out> n,
+      locale_ref loc,
+      basic_string_view<CharT> fmt,
+      const Args&... args) {
+    if constexpr (is_lowerable_iterator_v<Out>) {
+        const auto result = format_to_truncated_impl(to_raw_pointer(out), n,
+                                                     loc, fmt, args...);
+        return {to_iter(result.out, out), result.truncated};
+    } else if constexpr (erase_outputs && !has_own_context_v<Out>) {
+        const auto [end, size] = vformat_to_n_erased<true>(
+              out, n, loc, fmt, {make_buffer_format_args<CharT>(args...)});
+        return {end, size > truncation_limit<Out>(n)};
+    } else if constexpr (!is_direct_output_v<Out>) {
+        iterator_buffer<Out, CharT> buf(out);
+        const auto result = format_to_impl(
+              truncating_iter<buffer_iter<CharT>>{truncation_limit<Out>(n),
+                                                  buffer_iter<CharT>(buf)},
+              loc, fmt, args...);
+        return {buf.out(), result.truncated()};
+    } else {
+        const auto result = format_to_impl(
+              truncating_iter<Out>{truncation_limit<Out>(n), out}, loc, fmt,
+              args...);
+        return {result.iter(), result.truncated()};
+    }
+}
+template <class CharT, class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR format_to_truncated_result<Out> format_to_truncated_impl(
+      Out out,
+      iter_difference_t<Out> n,
+      basic_string_view<CharT> fmt,
+      const Args&... args) {
+    if constexpr (is_lowerable_iterator_v<Out>) {
+        const auto result =
+              format_to_truncated_impl(to_raw_pointer(out), n, fmt, args...);
+        return {to_iter(result.out, out), result.truncated};
+    } else if constexpr (erase_outputs && !has_own_context_v<Out>) {
+        const auto [end, size] = vformat_to_n_erased<true>(
+              out, n, locale_ref{}, fmt,
+              {make_buffer_format_args<CharT>(args...)});
+        return {end, size > truncation_limit<Out>(n)};
+    } else if constexpr (!is_direct_output_v<Out>) {
+        iterator_buffer<Out, CharT> buf(out);
+        const auto result = format_to_impl(
+              truncating_iter<buffer_iter<CharT>>{truncation_limit<Out>(n),
+                                                  buffer_iter<CharT>(buf)},
+              fmt, args...);
+        return {buf.out(), result.truncated()};
+    } else {
+        const auto result = format_to_impl(
+              truncating_iter<Out>{truncation_limit<Out>(n), out}, fmt,
+              args...);
+        return {result.iter(), result.truncated()};
+    }
 }
+}  // namespace detail
 
 template <class Out, class... Args>
-LRSTD_EXTRA_CONSTEXPR format_to_n_result<Out> format_to_n(
+LRSTD_EXTRA_CONSTEXPR format_to_truncated_result<Out> format_to_truncated(
       Out out,
       iter_difference_t<Out> n,
       std::string_view fmt,
       const Args&... args) {
-    auto result =
-          lrstd::format_to(detail::write_n_iter<Out>{n, out}, fmt, args...);
-    return format_to_n_result<Out>{result.iter(), result.count()};
+    return detail::format_to_truncated_impl(out, n, fmt, args...);
 }
 
 template <class Out, class... Args>
-LRSTD_EXTRA_CONSTEXPR format_to_n_result<Out> format_to_n(
+LRSTD_EXTRA_CONSTEXPR format_to_truncated_result<Out> format_to_truncated(
       Out out,
       iter_difference_t<Out> n,
       std::wstring_view fmt,
       const Args&... args) {
-    auto result =
-          lrstd::format_to(detail::write_n_iter<Out>{n, out}, fmt, args...);
-    return format_to_n_result<Out>{result.iter(), result.count()};
+    return detail::format_to_truncated_impl(out, n, fmt, args...);
 }
 
+// an upper bound on the size of formatting Args... with fmt, computable at
+// compile time. it's unbounded_formatted_size when nothing limits the output,
+// e.g. a string argument without a precision or a width given by an argument.
+inline constexpr std::size_t unbounded_formatted_size =
+      std::numeric_limits<std::size_t>::max();
+
+namespace detail {
+
+constexpr std::size_t saturating_add(std::size_t a, std::size_t b) noexcept {
+    return b > unbounded_formatted_size - a ? unbounded_formatted_size : a + b;
+}
+
+struct max_size_spec {
+    std::size_t width = 0;
+    std::size_t precision = unbounded_formatted_size;
+    bool alternate = false;
+    bool use_locale = false;
+    char type = '\0';
+};
+
+template <class Int>
+constexpr std::size_t max_integer_size(const max_size_spec& spec) noexcept {
+    constexpr std::size_t bits = sizeof(Int) * CHAR_BIT;
+    std::size_t digits = 0;
+    switch (spec.type) {
+        case 'c':
+            return 1;
+        case 'b':
+        case 'B':
+            digits = bits;
+            break;
+        case 'o':
+            digits = (bits + 2) / 3;
+            break;
+        case 'x':
+        case 'X':
+            digits = (bits + 3) / 4;
+            break;
+        default:
+            digits = std::numeric_limits<Int>::digits10 + 1;
+            break;
+    }
+    // a grouping can put a separator between every pair of digits
+    if (spec.use_locale)
+        digits = digits * 2 - 1;
+    return digits + 1 + (spec.alternate ? 2 : 0);
+}
+
+template <class T>
+struct unwrap_named_arg {
+    using type = T;
+};
+template <class CharT, class T>
+struct unwrap_named_arg<named_arg<CharT, T>> {
+    using type = T;
+};
+
+template <class T, class CharT>
+constexpr std::size_t max_value_size(const max_size_spec& spec) noexcept {
+    using U = std::remove_cv_t<typename unwrap_named_arg<
+          std::remove_cv_t<std::remove_reference_t<T>>>::type>;
+    if constexpr (std::is_same_v<U, bool>) {
+        if (spec.type == '\0' || spec.type == 's')
+            return spec.use_locale ? unbounded_formatted_size : 5;
+        return max_integer_size<bool>(spec);
+    } else if constexpr (std::is_same_v<U, CharT> || std::is_same_v<U, char>) {
+        if (spec.type == '\0' || spec.type == 'c')
+            return 1;
+        return max_integer_size<U>(spec);
+    } else if constexpr (std::is_integral_v<U>) {
+        return max_integer_size<U>(spec);
+    } else if constexpr (std::is_same_v<U, std::nullptr_t> ||
+                         std::is_same_v<U, void*> ||
+                         std::is_same_v<U, const void*>) {
+        return sizeof(void*) * 2 + 2;
+    } else if constexpr (std::is_array_v<U> && is_dynamic_string_v<U, CharT>) {
+        // a character array holds at most N - 1 characters before its null
+        return std::min(std::extent_v<U> - 1, spec.precision);
+    } else if constexpr (is_dynamic_string_v<U, CharT>) {
+        return spec.precision;
+    } else {
+        return unbounded_formatted_size;
+    }
+}
+
+template <class CharT, class... Args>
+constexpr std::size_t max_arg_size(std::size_t id,
+                                   const max_size_spec& spec) noexcept {
+    std::size_t size = 0;
+    std::size_t i = 0;
+    ((i++ == id ? size = max_value_size<Args, CharT>(spec) : 0), ...);
+    return size;
+}
+template <class CharT, class... Args>
+constexpr std::size_t max_any_arg_size(const max_size_spec& spec) noexcept {
+    std::size_t size = 0;
+    ((size = std::max(size, max_value_size<Args, CharT>(spec))), ...);
+    return size;
+}
+
+template <class CharT, class... Args>
+constexpr std::size_t max_formatted_size_impl(basic_string_view<CharT> fmt) {
+    constexpr std::size_t named = unbounded_formatted_size;
+    const std::size_t n = fmt.size();
+    std::size_t i = 0;
+    std::size_t next_arg = 0;
+
+    auto is_digit = [](CharT c) { return '0' <= c && c <= '9'; };
+    auto is_name_char = [&](CharT c) {
+        return is_digit(c) || ('a' <= c && c <= 'z') ||
+               ('A' <= c && c <= 'Z') || c == '_';
+    };
+    auto is_align = [](CharT c) { return c == '<' || c == '^' || c == '>'; };
+    auto parse_integer = [&] {
+        std::size_t value = 0;
+        for (; i != n && is_digit(fmt[i]); ++i)
+            value = value * 10 + static_cast<std::size_t>(fmt[i] - '0');
+        return value;
+    };
+    // an index, a name, or nothing for the next automatic index
+    auto parse_arg_id = [&]() -> std::size_t {
+        if (i != n && is_digit(fmt[i]))
+            return parse_integer();
+        if (i != n && is_name_char(fmt[i])) {
+            for (; i != n && is_name_char(fmt[i]); ++i)
+                ;
+            return named;
+        }
+        return next_arg++;
+    };
+    auto expect = [&](CharT c) {
+        if (i == n || fmt[i] != c)
+            throw_format_error("invalid format string");
+        ++i;
+    };
+    // {} or {n} in place of a width or precision
+    auto skip_nested_arg = [&] {
+        expect('{');
+        parse_arg_id();
+        expect('}');
+    };
+
+    std::size_t size = 0;
+    while (i != n) {
+        const CharT c = fmt[i++];
+        if (c == '}') {
+            expect('}');
+            size = saturating_add(size, 1);
+            continue;
+        }
+        if (c != '{') {
+            size = saturating_add(size, 1);
+            continue;
+        }
+        if (i != n && fmt[i] == '{') {
+            ++i;
+            size = saturating_add(size, 1);
+            continue;
+        }
+
+        const std::size_t id = parse_arg_id();
+        max_size_spec spec;
+        if (i != n && fmt[i] == ':') {
+            ++i;
+            if (i + 1 < n && is_align(fmt[i + 1]))
+                i += 2;
+            else if (i != n && is_align(fmt[i]))
+                ++i;
+            if (i != n && (fmt[i] == '+' || fmt[i] == '-' || fmt[i] == ' '))
+                ++i;
+            if (i != n && fmt[i] == '#') {
+                spec.alternate = true;
+                ++i;
+            }
+            if (i != n && fmt[i] == '0')
+                ++i;
+            if (i != n && fmt[i] == '{') {
+                skip_nested_arg();
+                spec.width = unbounded_formatted_size;
+            } else {
+                spec.width = parse_integer();
+            }
+            if (i != n && fmt[i] == '.') {
+                ++i;
+                if (i != n && fmt[i] == '{')
+                    skip_nested_arg();
+                else
+                    spec.precision = parse_integer();
+            }
+            if (i != n && fmt[i] == 'L') {
+                spec.use_locale = true;
+                ++i;
+            }
+            if (i != n && fmt[i] != '}')
+                spec.type = static_cast<char>(fmt[i++]);
+        }
+        expect('}');
+
+        std::size_t value_size = 0;
+        if (id == named)
+            value_size = max_any_arg_size<CharT, Args...>(spec);
+        else if (id < sizeof...(Args))
+            value_size = max_arg_size<CharT, Args...>(id, spec);
+        else
+            throw_format_error("argument not found");
+        size = saturating_add(size, std::max(spec.width, value_size));
+    }
+    return size;
+}
+
+}  // namespace detail
+
+template <class... Args>
+constexpr std::size_t max_formatted_size(std::string_view fmt) {
+    return detail::max_formatted_size_impl<char, Args...>(fmt);
+}
+template <class... Args>
+constexpr std::size_t max_formatted_size(std::wstring_view fmt) {
+    return detail::max_formatted_size_impl<wchar_t, Args...>(fmt);
+}
+
+// a fixed-capacity string that lives entirely in the object, for short
+// results that shouldn't allocate. always null-terminated.
+template <class CharT, std::size_t N>
+class inline_string {
+    CharT _data[N + 1];
+    std::size_t _size;
+
+   public:
+    using value_type = CharT;
+    using size_type = std::size_t;
+    using iterator = const CharT*;
+    using const_iterator = const CharT*;
+
+    constexpr inline_string() noexcept : _data{}, _size{0} {}
+
+    constexpr const CharT* data() const noexcept { return _data; }
+    constexpr const CharT* c_str() const noexcept { return _data; }
+    constexpr std::size_t size() const noexcept { return _size; }
+    constexpr bool empty() const noexcept { return _size == 0; }
+    static constexpr std::size_t capacity() noexcept { return N; }
+
+    constexpr const CharT* begin() const noexcept { return _data; }
+    constexpr const CharT* end() const noexcept { return _data + _size; }
+
+    constexpr std::basic_string_view<CharT> view() const noexcept {
+        return {_data, _size};
+    }
+    constexpr operator std::basic_string_view<CharT>() const noexcept {
+        return view();
+    }
+
+    // for filling in place. new_size must be at most N.
+    constexpr CharT* _buffer() noexcept { return _data; }
+    constexpr void _set_size(std::size_t new_size) noexcept {
+        LRSTD_ASSERT(new_size <= N);
+        _size = new_size;
+        _data[new_size] = CharT();
+    }
+};
+
+enum class overflow_policy : char {
+    throw_error,  // throw format_error if the output doesn't fit
+    truncate,     // keep the first N characters
+};
+
+namespace detail {
+template <std::size_t N, overflow_policy Policy, class CharT, class... Args>
+inline_string<CharT, N> format_small_impl(basic_string_view<CharT> fmt,
+                                          const Args&... args) {
+    inline_string<CharT, N> result;
+    const auto r = format_to_truncated_impl(
+          result._buffer(), static_cast<std::ptrdiff_t>(N), fmt, args...);
+    if (Policy == overflow_policy::throw_error && r.truncated)
+        throw_format_error("output doesn't fit in format_small's capacity");
+    result._set_size(static_cast<std::size_t>(r.out - result._buffer()));
+    return result;
+}
+}  // namespace detail
+
+// format into an inline_string<CharT, N>, never touching the heap
+template <std::size_t N,
+          overflow_policy Policy = overflow_policy::throw_error,
+          class... Args>
+inline_string<char, N> format_small(std::string_view fmt,
+                                    const Args&... args) {
+    return detail::format_small_impl<N, Policy>(fmt, args...);
+}
+template <std::size_t N,
+          overflow_policy Policy = overflow_policy::throw_error,
+          class... Args>
+inline_string<wchar_t, N> format_small(std::wstring_view fmt,
+                                       const Args&... args) {
+    return detail::format_small_impl<N, Policy>(fmt, args...);
+}
+
+// formats into a sequence of caller-provided chunks of memory, for output
+// that is sent out in fixed-size pieces. each fill() picks up where the last
+// one stopped: output of a field that didn't fit is kept until the next
+// call, but nothing beyond one field is formatted ahead. that field is
+// formatted whole, so a long string or a wide fill is copied in full into
+// memory the formatter holds on to until later fills have handed it out;
+// pending() says how much that is. the format string and args have to
+// outlive the formatter. after a fill() has thrown, the formatter can't be
+// used again.
+template <class CharT>
+class basic_chunked_formatter {
+    using context = basic_format_context<detail::buffer_iter<CharT>, CharT>;
+
+    basic_format_args<context> _args;
+    std::shared_ptr<const void> _locale_copy;
+    detail::locale_ref _locale;
+    basic_format_parse_context<CharT> _parse_context;
+    detail::chunk_buffer<CharT> _buf;
+
+    void format_chunk() {
+        const detail::buffer_iter<CharT> out(_buf);
+        context ctx(_args, out, _locale);
+        lrstd::detail::format_pieces(ctx, _parse_context,
+                                     [&] { return _buf.overflowing(); });
+    }
+
+   public:
+    struct fill_result {
+        std::size_t size;  // how much of the chunk was written
+        bool done;         // whether that was the end of the output
+    };
+
+    basic_chunked_formatter(basic_string_view<CharT> fmt,
+                            basic_format_args<context> args) noexcept
+        : _args{args}, _parse_context(fmt, args._get_size()) {}
+    // with format_locale.hpp, for a std::locale, which is copied
+    template <class Locale,
+              class = typename detail::locale_traits<Locale>::type>
+    basic_chunked_formatter(const Locale& loc,
+                            basic_string_view<CharT> fmt,
+                            basic_format_args<context> args)
+        : basic_chunked_formatter(fmt, args) {
+        const auto copy = std::make_shared<const Locale>(loc);
+        _locale = detail::locale_traits<Locale>::ref(*copy);
+        _locale_copy = copy;
+    }
+
+    bool done() const noexcept {
+        return _parse_context.begin() == _parse_context.end() &&
+               !_buf.has_pending();
+    }
+
+    // how much output earlier fills formatted but couldn't hand out yet
+    std::size_t pending() const noexcept { return _buf.pending(); }
+
+    // writes the next part of the output to [first, first + n). only the
+    // last chunk, the one with done set, can be short.
+    fill_result fill(CharT* first, std::size_t n) {
+        const std::size_t pending = _buf.take_pending(first, n);
+        if (pending != n && !done()) {
+            _buf.start_chunk(first + pending, n - pending);
+            format_chunk();
+            return {pending + _buf.end_chunk(), done()};
+        }
+        return {pending, done()};
+    }
+#if defined(__cpp_lib_span)
+    fill_result fill(std::span<CharT> chunk) {
+        return fill(chunk.data(), chunk.size());
+    }
+#endif
+};
+
+using chunked_formatter = basic_chunked_formatter<char>;
+using wchunked_formatter = basic_chunked_formatter<wchar_t>;
+
+#if LRSTD_FORMAT_COMPILED
+// format_compiled is built for one configuration. src/format.cpp defines a
+// symbol named after it and every other user refers to that symbol, so code
+// built with another configuration fails to link instead of mixing
+// instantiations.
+#if LRSTD_USE_THREAD_LOCAL_BUFFER
+#define LRSTD_FORMAT_CONFIG_TLB thread_local_buffer
+#else
+#define LRSTD_FORMAT_CONFIG_TLB no_thread_local_buffer
+#endif
+#if LRSTD_USE_EXTRA_CONSTEXPR
+#define LRSTD_FORMAT_CONFIG_CX extra_constexpr
+#else
+#define LRSTD_FORMAT_CONFIG_CX no_extra_constexpr
+#endif
+#define LRSTD_FORMAT_CONFIG_NAME_(tlb, cx) compiled_with_##tlb##_##cx
+#define LRSTD_FORMAT_CONFIG_NAME(tlb, cx) LRSTD_FORMAT_CONFIG_NAME_(tlb, cx)
+#define LRSTD_FORMAT_CONFIG \
+    LRSTD_FORMAT_CONFIG_NAME(LRSTD_FORMAT_CONFIG_TLB, LRSTD_FORMAT_CONFIG_CX)
+
+namespace detail {
+#ifdef LRSTD_FORMAT_INSTANTIATE
+extern const bool LRSTD_FORMAT_CONFIG = true;
+#else
+extern const bool LRSTD_FORMAT_CONFIG;
+[[maybe_unused]] LRSTD_USED static const bool* const compiled_config_check =
+      &LRSTD_FORMAT_CONFIG;
+#endif
+}  // namespace detail
+
+#undef LRSTD_FORMAT_CONFIG
+#undef LRSTD_FORMAT_CONFIG_NAME
+#undef LRSTD_FORMAT_CONFIG_NAME_
+#undef LRSTD_FORMAT_CONFIG_CX
+#undef LRSTD_FORMAT_CONFIG_TLB
+#endif
+
+#if LRSTD_FORMAT_COMPILED && !LRSTD_USE_EXTRA_CONSTEXPR
+// everything the public functions funnel into, for char and wchar_t and the
+// library's own outputs. src/format.cpp defines LRSTD_FORMAT_INSTANTIATE as
+// template to instantiate them; everywhere else they're extern.
+#ifndef LRSTD_FORMAT_INSTANTIATE
+#define LRSTD_FORMAT_INSTANTIATE extern template
+#endif
+
+#define LRSTD_FORMAT_INSTANTIATE_OUT(CharT, Out)                             \
+    LRSTD_FORMAT_INSTANTIATE Out vformat_to_impl<CharT, Out>(                \
+          Out, locale_ref, basic_string_view<CharT>,                         \
+          format_args_t<Out, CharT>&);                                       \
+    LRSTD_FORMAT_INSTANTIATE Out vformat_to_impl<CharT, Out>(                \
+          Out, basic_string_view<CharT>, format_args_t<Out, CharT>&)
+
+#define LRSTD_FORMAT_INSTANTIATE_CHAR(CharT)                                 \
+    LRSTD_FORMAT_INSTANTIATE std::basic_string<CharT> vformat_impl<CharT>(   \
+          locale_ref, basic_string_view<CharT>,                              \
+          format_args_t<buffer_iter<CharT>, CharT>);                         \
+    LRSTD_FORMAT_INSTANTIATE std::basic_string<CharT> vformat_impl<CharT>(   \
+          basic_string_view<CharT>, format_args_t<buffer_iter<CharT>, CharT>); \
+    LRSTD_FORMAT_INSTANTIATE basic_string_view<CharT>                        \
+    vformat_view_impl<CharT>(locale_ref, basic_string_view<CharT>,           \
+                             format_args_t<buffer_iter<CharT>, CharT>);      \
+    LRSTD_FORMAT_INSTANTIATE basic_string_view<CharT>                        \
+    vformat_view_impl<CharT>(basic_string_view<CharT>,                       \
+                             format_args_t<buffer_iter<CharT>, CharT>);      \
+    LRSTD_FORMAT_INSTANTIATE void vformat_append_impl<                       \
+          CharT, std::char_traits<CharT>, std::allocator<CharT>>(            \
+          std::basic_string<CharT>&, locale_ref,                             \
+          basic_string_view<CharT>, format_args_t<buffer_iter<CharT>, CharT>); \
+    LRSTD_FORMAT_INSTANTIATE void vformat_append_impl<                       \
+          CharT, std::char_traits<CharT>, std::allocator<CharT>>(            \
+          std::basic_string<CharT>&, basic_string_view<CharT>,               \
+          format_args_t<buffer_iter<CharT>, CharT>);                         \
+    LRSTD_FORMAT_INSTANTIATE void vformat_to_buffer<CharT, never_done>(      \
+          buffer<CharT>&, locale_ref, basic_string_view<CharT>,              \
+          format_args_t<buffer_iter<CharT>, CharT>, never_done);             \
+    LRSTD_FORMAT_INSTANTIATE void                                            \
+    vformat_to_buffer<CharT, limit_reached<CharT>>(                          \
+          buffer<CharT>&, locale_ref, basic_string_view<CharT>,              \
+          format_args_t<buffer_iter<CharT>, CharT>, limit_reached<CharT>);   \
+    LRSTD_FORMAT_INSTANTIATE_OUT(CharT, buffer_iter<CharT>);                 \
+    LRSTD_FORMAT_INSTANTIATE_OUT(CharT, count_iter);                         \
+    LRSTD_FORMAT_INSTANTIATE_OUT(CharT, scatter_iter<CharT>);                \
+    LRSTD_FORMAT_INSTANTIATE_OUT(CharT, stream_iter<CharT>)
+
+namespace detail {
+LRSTD_FORMAT_INSTANTIATE_CHAR(char);
+LRSTD_FORMAT_INSTANTIATE_CHAR(wchar_t);
+}  // namespace detail
+
+#undef LRSTD_FORMAT_INSTANTIATE_CHAR
+#undef LRSTD_FORMAT_INSTANTIATE_OUT
+#undef LRSTD_FORMAT_INSTANTIATE
+#endif
+
 }  // namespace lrstd
 
+// std::locale support. a translation unit that sets LRSTD_FORMAT_NO_LOCALE
+// does without <locale>; 'L' without a locale then throws format_error unless
+// some other part of the program includes format_locale.hpp.
+#if !LRSTD_FORMAT_NO_LOCALE
+#include "format_locale.hpp"
+#endif
+
 #endif
@@ -0,0 +1,270 @@
+#ifndef LRSTD_FORMAT_LOCALE_HPP
+#define LRSTD_FORMAT_LOCALE_HPP
+
+#include "format.hpp"
+
+#include <locale>
+#include <string>
+
+namespace lrstd {
+
+namespace detail {
+
+template <class CharT>
+numpunct_data<CharT> std_numpunct(const void* loc) {
+    const auto& np = std::use_facet<std::numpunct<CharT>>(
+          loc ? *static_cast<const std::locale*>(loc) : std::locale());
+    return {np.thousands_sep(), np.grouping(), np.truename(), np.falsename()};
+}
+
+inline constexpr locale_hooks std_locale_hooks{&std_numpunct<char>,
+                                               &std_numpunct<wchar_t>};
+
+// 'L' without a locale uses the global std::locale in every translation
+// unit once this header is part of the program. like std::ios_base::Init,
+// each including translation unit installs the hooks itself, ahead of its
+// own static initializers.
+struct std_locale_hooks_init {
+    std_locale_hooks_init() noexcept { global_locale_hooks = &std_locale_hooks; }
+};
+static const std_locale_hooks_init std_locale_hooks_installer;
+
+inline constexpr locale_ref std_locale_ref(const std::locale& loc) noexcept {
+    return {loc, std_locale_hooks};
+}
+
+template <>
+struct locale_traits<std::locale> {
+    using type = std::locale;
+    static constexpr locale_ref ref(const std::locale& loc) noexcept {
+        return std_locale_ref(loc);
+    }
+};
+template <>
+struct locale_traits<void> : locale_traits<std::locale> {};
+
+}  // namespace detail
+
+template <class Out>
+LRSTD_EXTRA_CONSTEXPR Out vformat_to(Out out,
+                                     const std::locale& loc,
+                                     std::string_view fmt,
+                                     format_args_t<Out, char> args) {
+    return detail::vformat_to_impl(out, detail::std_locale_ref(loc), fmt, args);
+}
+
+template <class Out>
+LRSTD_EXTRA_CONSTEXPR Out vformat_to(Out out,
+                                     const std::locale& loc,
+                                     std::wstring_view fmt,
+                                     format_args_t<Out, wchar_t> args) {
+    return detail::vformat_to_impl(out, detail::std_locale_ref(loc), fmt, args);
+}
+
+template <class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR Out format_to(Out out,
+                                    const std::locale& loc,
+                                    std::string_view fmt,
+                                    const Args&... args) {
+    return detail::format_to_impl(out, detail::std_locale_ref(loc), fmt,
+                                  args...);
+}
+
+template <class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR Out format_to(Out out,
+                                    const std::locale& loc,
+                                    std::wstring_view fmt,
+                                    const Args&... args) {
+    return detail::format_to_impl(out, detail::std_locale_ref(loc), fmt,
+                                  args...);
+}
+
+inline std::string vformat(const std::locale& loc,
+                           std::string_view fmt,
+                           format_args args) {
+    return detail::vformat_impl(detail::std_locale_ref(loc), fmt, args);
+}
+
+inline std::wstring vformat(const std::locale& loc,
+                            std::wstring_view fmt,
+                            wformat_args args) {
+    return detail::vformat_impl(detail::std_locale_ref(loc), fmt, args);
+}
+
+inline std::string_view vformat_view(const std::locale& loc,
+                                     std::string_view fmt,
+                                     format_args args) {
+    return detail::vformat_view_impl(detail::std_locale_ref(loc), fmt, args);
+}
+
+inline std::wstring_view vformat_view(const std::locale& loc,
+                                      std::wstring_view fmt,
+                                      wformat_args args) {
+    return detail::vformat_view_impl(detail::std_locale_ref(loc), fmt, args);
+}
+
+template <class... Args>
+std::string_view format_view(const std::locale& loc,
+                             std::string_view fmt,
+                             const Args&... args) {
+    return lrstd::vformat_view(loc, fmt, {make_format_args(args...)});
+}
+
+template <class... Args>
+std::wstring_view format_view(const std::locale& loc,
+                              std::wstring_view fmt,
+                              const Args&... args) {
+    return lrstd::vformat_view(loc, fmt, {make_wformat_args(args...)});
+}
+
+inline void vformat_append(std::string& str,
+                           const std::locale& loc,
+                           std::string_view fmt,
+                           format_args args) {
+    detail::vformat_append_impl(str, detail::std_locale_ref(loc), fmt, args);
+}
+
+inline void vformat_append(std::wstring& str,
+                           const std::locale& loc,
+                           std::wstring_view fmt,
+                           wformat_args args) {
+    detail::vformat_append_impl(str, detail::std_locale_ref(loc), fmt, args);
+}
+
+template <class... Args>
+void format_append(std::string& str,
+                   const std::locale& loc,
+                   std::string_view fmt,
+                   const Args&... args) {
+    lrstd::vformat_append(str, loc, fmt, {make_format_args(args...)});
+}
+
+template <class... Args>
+void format_append(std::wstring& str,
+                   const std::locale& loc,
+                   std::wstring_view fmt,
+                   const Args&... args) {
+    lrstd::vformat_append(str, loc, fmt, {make_wformat_args(args...)});
+}
+
+template <class... Args>
+std::string format(const std::locale& loc,
+                   std::string_view fmt,
+                   const Args&... args) {
+    return lrstd::vformat(loc, fmt, {make_format_args(args...)});
+}
+
+template <class... Args>
+std::wstring format(const std::locale& loc,
+                    std::wstring_view fmt,
+                    const Args&... args) {
+    return lrstd::vformat(loc, fmt, {make_wformat_args(args...)});
+}
+
+template <class Alloc,
+          class = detail::enable_if_char_allocator_t<Alloc, char>>
+detail::string_for_allocator<Alloc> vformat(const Alloc& alloc,
+                                            const std::locale& loc,
+                                            std::string_view fmt,
+                                            format_args args) {
+    return detail::vformat_impl(alloc, detail::std_locale_ref(loc), fmt, args);
+}
+
+template <class Alloc,
+          class = detail::enable_if_char_allocator_t<Alloc, wchar_t>>
+detail::string_for_allocator<Alloc> vformat(const Alloc& alloc,
+                                            const std::locale& loc,
+                                            std::wstring_view fmt,
+                                            wformat_args args) {
+    return detail::vformat_impl(alloc, detail::std_locale_ref(loc), fmt, args);
+}
+
+template <class Alloc,
+          class... Args,
+          class = detail::enable_if_char_allocator_t<Alloc, char>>
+detail::string_for_allocator<Alloc> format(const Alloc& alloc,
+                                           const std::locale& loc,
+                                           std::string_view fmt,
+                                           const Args&... args) {
+    return lrstd::vformat(alloc, loc, fmt, {make_format_args(args...)});
+}
+
+template <class Alloc,
+          class... Args,
+          class = detail::enable_if_char_allocator_t<Alloc, wchar_t>>
+detail::string_for_allocator<Alloc> format(const Alloc& alloc,
+                                           const std::locale& loc,
+                                           std::wstring_view fmt,
+                                           const Args&... args) {
+    return lrstd::vformat(alloc, loc, fmt, {make_wformat_args(args...)});
+}
+
+template <class... Args>
+LRSTD_EXTRA_CONSTEXPR std::size_t formatted_size(const std::locale& loc,
+                                                 std::string_view fmt,
+                                                 const Args&... args) {
+    using Context = basic_format_context<detail::count_iter,
+                                         std::string_view::value_type>;
+    return lrstd::vformat_to(detail::count_iter{}, loc, fmt,
+                             {make_format_args<Context>(args...)})
+          .count();
+}
+
+template <class... Args>
+LRSTD_EXTRA_CONSTEXPR std::size_t formatted_size(const std::locale& loc,
+                                                 std::wstring_view fmt,
+                                                 const Args&... args) {
+    using Context = basic_format_context<detail::count_iter,
+                                         std::wstring_view::value_type>;
+    return lrstd::vformat_to(detail::count_iter{}, loc, fmt,
+                             {make_format_args<Context>(args...)})
+          .count();
+}
+
+template <class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR format_to_n_result<Out> format_to_n(
+      Out out,
+      iter_difference_t<Out> n,
+      const std::locale& loc,
+      std::string_view fmt,
+      const Args&... args) {
+    return detail::format_to_n_impl(out, n, detail::std_locale_ref(loc), fmt,
+                                    args...);
+}
+
+template <class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR format_to_n_result<Out> format_to_n(
+      Out out,
+      iter_difference_t<Out> n,
+      const std::locale& loc,
+      std::wstring_view fmt,
+      const Args&... args) {
+    return detail::format_to_n_impl(out, n, detail::std_locale_ref(loc), fmt,
+                                    args...);
+}
+
+template <class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR format_to_truncated_result<Out> format_to_truncated(
+      Out out,
+      iter_difference_t<Out> n,
+      const std::locale& loc,
+      std::string_view fmt,
+      const Args&... args) {
+    return detail::format_to_truncated_impl(
+          out, n, detail::std_locale_ref(loc), fmt, args...);
+}
+
+template <class Out, class... Args>
+LRSTD_EXTRA_CONSTEXPR format_to_truncated_result<Out> format_to_truncated(
+      Out out,
+      iter_difference_t<Out> n,
+      const std::locale& loc,
+      std::wstring_view fmt,
+      const Args&... args) {
+    return detail::format_to_truncated_impl(
+          out, n, detail::std_locale_ref(loc), fmt, args...);
+}
+
+}  // namespace lrstd
+
+#endif
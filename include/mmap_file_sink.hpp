@@ -0,0 +1,157 @@
+#ifndef LRSTD_FORMAT_MMAP_FILE_SINK_HPP
+#define LRSTD_FORMAT_MMAP_FILE_SINK_HPP
+
+#include "print.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace lrstd {
+
+struct mmap_file_options {
+    // how much the file and mapping grow by at a time
+    std::size_t chunk_size = std::size_t(64) << 20;
+    // madvise(MADV_SEQUENTIAL) every mapping
+    bool sequential = true;
+    // start writeback (msync with MS_ASYNC) of everything written so far
+    // whenever the mapping grows
+    bool sync_behind = false;
+};
+
+// a file written through a shared mapping of it: output is copied straight
+// into the page cache, without write calls or a second copy. the file is
+// extended and remapped a chunk at a time, and truncated to exactly what was
+// written by close(). format into it with format_to(sink.out(), ...).
+class mmap_file_sink : detail::buffer<char> {
+    int _fd = -1;
+    char* _map = nullptr;
+    std::size_t _synced = 0;
+    mmap_file_options _options;
+
+    static void grow(detail::buffer<char>& buf, std::size_t capacity) {
+        auto& self = static_cast<mmap_file_sink&>(buf);
+        self.remap(std::max(capacity,
+                            self.capacity() + self._options.chunk_size));
+    }
+
+    static std::size_t page_size() {
+        static const auto size =
+              static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    void remap(std::size_t capacity) {
+        capacity = (capacity + page_size() - 1) / page_size() * page_size();
+        if (_options.sync_behind)
+            sync_behind();
+        extend(capacity);
+        void* map;
+        if (!_map)
+            map = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         _fd, 0);
+#if defined(__linux__)
+        else
+            map = ::mremap(_map, this->capacity(), capacity, MREMAP_MAYMOVE);
+#else
+        else {
+            ::munmap(_map, this->capacity());
+            _map = nullptr;
+            this->set(nullptr, 0);
+            map = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         _fd, 0);
+        }
+#endif
+        if (map == MAP_FAILED)
+            detail::throw_io_error(errno, "mmap");
+        _map = static_cast<char*>(map);
+        if (_options.sequential)
+            ::madvise(_map, capacity, MADV_SEQUENTIAL);
+        this->set(_map, capacity);
+    }
+
+    // allocates the blocks up front where the file system can, so that a
+    // full disk fails here rather than with SIGBUS on a store to the mapping
+    void extend(std::size_t capacity) {
+        const std::size_t old = this->capacity();
+#if defined(__linux__) || defined(__FreeBSD__)
+        const int error = ::posix_fallocate(_fd, static_cast<off_t>(old),
+                                            static_cast<off_t>(capacity - old));
+        if (error == 0)
+            return;
+        if (error != EINVAL && error != EOPNOTSUPP)
+            detail::throw_io_error(error, "posix_fallocate");
+#endif
+        if (::ftruncate(_fd, static_cast<off_t>(capacity)) != 0)
+            detail::throw_io_error(errno, "ftruncate");
+    }
+
+    void sync_behind() {
+        const std::size_t end = this->size() / page_size() * page_size();
+        if (end > _synced) {
+            ::msync(_map + _synced, end - _synced, MS_ASYNC);
+            _synced = end;
+        }
+    }
+
+   public:
+    explicit mmap_file_sink(const char* path, mmap_file_options options = {})
+        : buffer<char>{&grow}, _options{options} {
+        _options.chunk_size = std::max(_options.chunk_size, page_size());
+        _fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (_fd < 0)
+            detail::throw_io_error(errno, "open");
+        try {
+            remap(_options.chunk_size);
+        } catch (...) {
+            ::close(_fd);
+            throw;
+        }
+    }
+    explicit mmap_file_sink(const std::string& path,
+                            mmap_file_options options = {})
+        : mmap_file_sink(path.c_str(), options) {}
+
+    // errors are only reported by an explicit close()
+    ~mmap_file_sink() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    using detail::buffer<char>::size;
+
+    detail::buffer_iter<char> out() noexcept {
+        return detail::buffer_iter<char>(*this);
+    }
+
+    bool is_open() const noexcept { return _fd >= 0; }
+
+    // unmaps the file and truncates it to size()
+    void close() {
+        if (_fd < 0)
+            return;
+        if (_map)
+            ::munmap(_map, this->capacity());
+        _map = nullptr;
+        const int fd = _fd;
+        _fd = -1;
+        const bool truncated =
+              ::ftruncate(fd, static_cast<off_t>(this->size())) == 0;
+        const int error = errno;
+        this->set(nullptr, 0);
+        if (::close(fd) != 0 && truncated)
+            detail::throw_io_error(errno, "close");
+        if (!truncated)
+            detail::throw_io_error(error, "ftruncate");
+    }
+};
+
+}  // namespace lrstd
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef LRSTD_FORMAT_PRINT_HPP
+#define LRSTD_FORMAT_PRINT_HPP
+
+#include "format.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace lrstd {
+
+inline constexpr std::size_t print_buffer_size = 4096;
+
+namespace detail {
+
+[[noreturn]] inline void throw_io_error(int error, const char* what) {
+    throw std::system_error(error, std::generic_category(), what);
+}
+
+// holds a FILE's lock for the duration of one print, so that the unlocked
+// writes underneath don't interleave with other threads
+class file_lock {
+    std::FILE* _file;
+
+   public:
+    explicit file_lock(std::FILE* file) noexcept : _file{file} {
+        flockfile(file);
+    }
+    file_lock(const file_lock&) = delete;
+    file_lock& operator=(const file_lock&) = delete;
+    ~file_lock() { funlockfile(_file); }
+};
+
+// the caller holds the lock
+inline void write_all(std::FILE* file, const char* data, std::size_t size) {
+    errno = 0;
+#if defined(__GLIBC__)
+    const std::size_t written = fwrite_unlocked(data, 1, size, file);
+#else
+    const std::size_t written = std::fwrite(data, 1, size, file);
+#endif
+    if (written != size)
+        throw_io_error(errno != 0 ? errno : EIO, "fwrite");
+}
+
+inline void write_all(int fd, const char* data, std::size_t size) {
+    while (size != 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            throw_io_error(errno, "write");
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+#ifdef IOV_MAX
+inline constexpr std::size_t iovec_batch_size = IOV_MAX;
+#else
+inline constexpr std::size_t iovec_batch_size = 1024;
+#endif
+
+// writev in batches of at most iovec_batch_size, picking up partial writes
+// where they left off. the iovecs are consumed along the way.
+inline void write_all(int fd, iovec* iov, std::size_t count) {
+    while (count != 0) {
+        const ssize_t written = ::writev(
+              fd, iov, static_cast<int>(std::min(count, iovec_batch_size)));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            throw_io_error(errno, "writev");
+        }
+        auto left = static_cast<std::size_t>(written);
+        for (; count != 0 && left >= iov->iov_len; ++iov, --count)
+            left -= iov->iov_len;
+        if (left != 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+}
+
+// a stack buffer in front of a FILE or file descriptor. it's written out
+// whenever it fills up, and once more by flush() at the end.
+template <class Sink>
+class print_buffer : public buffer<char> {
+    Sink _sink;
+    char _data[print_buffer_size];
+
+    static void grow(buffer<char>& buf, std::size_t) {
+        static_cast<print_buffer&>(buf).flush();
+    }
+
+   public:
+    explicit print_buffer(Sink sink) : buffer<char>{&grow}, _sink{sink} {
+        this->set(_data, print_buffer_size);
+    }
+
+    void flush() {
+        write_all(_sink, _data, this->size());
+        this->clear();
+    }
+};
+
+template <class Sink>
+void vprint_impl(Sink sink,
+                 std::string_view fmt,
+                 format_args args,
+                 bool newline) {
+    print_buffer<Sink> buf(sink);
+    vformat_to_impl(buffer_iter<char>(buf), fmt, args);
+    if (newline)
+        buf.push_back('\n');
+    buf.flush();
+}
+
+}  // namespace detail
+
+// output that is sent with a single writev. literal text from the format
+// string and string arguments of at least borrow_min characters are
+// referred to where they are instead of being copied, so they have to
+// outlive write(); everything else (numbers, padding, short text) is kept in
+// a side buffer. format into it with format_to(iov.out(), ...).
+class format_iovec {
+    detail::scatter_buffer<char> _buf;
+
+   public:
+    using iterator = detail::scatter_iter<char>;
+
+    explicit format_iovec(std::size_t borrow_min = 64) noexcept
+        : _buf{borrow_min} {}
+
+    iterator out() noexcept { return iterator(_buf); }
+
+    // valid until the next write into the format_iovec
+    std::vector<iovec> iovecs() {
+        std::vector<iovec> result;
+        _buf.for_each_span([&](const char* data, std::size_t size) {
+            result.push_back({const_cast<char*>(data), size});
+        });
+        return result;
+    }
+
+    std::size_t size() {
+        std::size_t total = 0;
+        _buf.for_each_span(
+              [&](const char*, std::size_t size) { total += size; });
+        return total;
+    }
+
+    void write(int fd) {
+        std::vector<iovec> iov = iovecs();
+        detail::write_all(fd, iov.data(), iov.size());
+    }
+
+    void clear() noexcept { _buf.clear(); }
+};
+
+inline void vprint(std::FILE* file, std::string_view fmt, format_args args) {
+    detail::file_lock lock(file);
+    detail::vprint_impl(file, fmt, args, false);
+}
+inline void vprint(int fd, std::string_view fmt, format_args args) {
+    detail::vprint_impl(fd, fmt, args, false);
+}
+inline void vprint(std::string_view fmt, format_args args) {
+    lrstd::vprint(stdout, fmt, args);
+}
+
+inline void vprintln(std::FILE* file, std::string_view fmt, format_args args) {
+    detail::file_lock lock(file);
+    detail::vprint_impl(file, fmt, args, true);
+}
+inline void vprintln(int fd, std::string_view fmt, format_args args) {
+    detail::vprint_impl(fd, fmt, args, true);
+}
+inline void vprintln(std::string_view fmt, format_args args) {
+    lrstd::vprintln(stdout, fmt, args);
+}
+
+template <class... Args>
+void print(std::FILE* file, std::string_view fmt, const Args&... args) {
+    lrstd::vprint(file, fmt, {make_format_args(args...)});
+}
+template <class... Args>
+void print(int fd, std::string_view fmt, const Args&... args) {
+    lrstd::vprint(fd, fmt, {make_format_args(args...)});
+}
+template <class... Args>
+void print(std::string_view fmt, const Args&... args) {
+    lrstd::vprint(stdout, fmt, {make_format_args(args...)});
+}
+
+template <class... Args>
+void println(std::FILE* file, std::string_view fmt, const Args&... args) {
+    lrstd::vprintln(file, fmt, {make_format_args(args...)});
+}
+template <class... Args>
+void println(int fd, std::string_view fmt, const Args&... args) {
+    lrstd::vprintln(fd, fmt, {make_format_args(args...)});
+}
+template <class... Args>
+void println(std::string_view fmt, const Args&... args) {
+    lrstd::vprintln(stdout, fmt, {make_format_args(args...)});
+}
+
+}  // namespace lrstd
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef LRSTD_FORMAT_URING_FILE_SINK_HPP
+#define LRSTD_FORMAT_URING_FILE_SINK_HPP
+
+#include "print.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define LRSTD_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#else
+#define LRSTD_HAS_IO_URING 0
+#endif
+
+namespace lrstd {
+
+struct uring_file_options {
+    // size of each buffer in the ring
+    std::size_t buffer_size = std::size_t(256) << 10;
+    // how many buffers there are: one being formatted into, the rest can
+    // be in flight
+    unsigned buffer_count = 8;
+    // skip io_uring and pwrite each buffer as it fills
+    bool use_pwrite = false;
+};
+
+namespace detail {
+
+#if LRSTD_HAS_IO_URING
+// the bare minimum of an io_uring, driven by one thread through the raw
+// system calls: submissions go out one at a time, completions are reaped
+// either as they're there or by waiting for them.
+class io_uring_queue {
+    int _fd = -1;
+    void* _sq_map = MAP_FAILED;
+    std::size_t _sq_map_size = 0;
+    void* _cq_map = MAP_FAILED;
+    std::size_t _cq_map_size = 0;
+    io_uring_sqe* _sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t _sqes_size = 0;
+
+    unsigned* _sq_tail;
+    unsigned _sq_mask;
+    unsigned* _sq_array;
+    unsigned* _cq_head;
+    unsigned* _cq_tail;
+    unsigned _cq_mask;
+    io_uring_cqe* _cqes;
+
+    static void* map(std::size_t size, int fd, off_t offset) {
+        return ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, offset);
+    }
+    template <class T>
+    static T* at(void* base, unsigned offset) {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+
+    bool fail() noexcept {
+        close();
+        return false;
+    }
+
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        long result;
+        do
+            result = ::syscall(__NR_io_uring_enter, _fd, to_submit,
+                               min_complete, flags, nullptr, 0);
+        while (result < 0 && errno == EINTR);
+        return result < 0 ? errno : 0;
+    }
+
+   public:
+    io_uring_queue() = default;
+    io_uring_queue(const io_uring_queue&) = delete;
+    io_uring_queue& operator=(const io_uring_queue&) = delete;
+    ~io_uring_queue() { close(); }
+
+    // false if the kernel doesn't support (or doesn't allow) io_uring
+    bool open(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof params);
+        _fd = static_cast<int>(
+              ::syscall(__NR_io_uring_setup, entries, &params));
+        if (_fd < 0)
+            return false;
+
+        _sq_map_size =
+              params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_map_size =
+              params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            _sq_map_size = _cq_map_size =
+                  std::max(_sq_map_size, _cq_map_size);
+        _sq_map = map(_sq_map_size, _fd, IORING_OFF_SQ_RING);
+        if (_sq_map == MAP_FAILED)
+            return fail();
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            _cq_map = _sq_map;
+        else
+            _cq_map = map(_cq_map_size, _fd, IORING_OFF_CQ_RING);
+        if (_cq_map == MAP_FAILED)
+            return fail();
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe*>(
+              map(_sqes_size, _fd, IORING_OFF_SQES));
+        if (_sqes == MAP_FAILED)
+            return fail();
+
+        _sq_tail = at<unsigned>(_sq_map, params.sq_off.tail);
+        _sq_mask = *at<unsigned>(_sq_map, params.sq_off.ring_mask);
+        _sq_array = at<unsigned>(_sq_map, params.sq_off.array);
+        _cq_head = at<unsigned>(_cq_map, params.cq_off.head);
+        _cq_tail = at<unsigned>(_cq_map, params.cq_off.tail);
+        _cq_mask = *at<unsigned>(_cq_map, params.cq_off.ring_mask);
+        _cqes = at<io_uring_cqe>(_cq_map, params.cq_off.cqes);
+        return true;
+    }
+
+    void close() noexcept {
+        if (_sqes != MAP_FAILED)
+            ::munmap(_sqes, _sqes_size);
+        if (_cq_map != MAP_FAILED && _cq_map != _sq_map)
+            ::munmap(_cq_map, _cq_map_size);
+        if (_sq_map != MAP_FAILED)
+            ::munmap(_sq_map, _sq_map_size);
+        if (_fd >= 0)
+            ::close(_fd);
+        _fd = -1;
+        _sq_map = _cq_map = MAP_FAILED;
+        _sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    }
+
+    bool register_buffers(const iovec* iov, unsigned count) {
+        return ::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS,
+                         iov, count) == 0;
+    }
+
+    // whether the kernel can do the opcode. kernels too old to be asked
+    // count as not supporting it.
+    bool supports(unsigned op) {
+        constexpr unsigned count = 256;
+        alignas(io_uring_probe) unsigned char
+              storage[sizeof(io_uring_probe) +
+                      count * sizeof(io_uring_probe_op)] = {};
+        auto* const probe = reinterpret_cast<io_uring_probe*>(storage);
+        if (::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE,
+                      probe, count) != 0)
+            return false;
+        return op <= probe->last_op && op < probe->ops_len &&
+               (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    // fills in the next submission and hands it to the kernel. there is
+    // never more in flight than the queue has entries for. a failed
+    // io_uring_enter hasn't consumed the submission, so it's taken back.
+    template <class Fill>
+    void submit(Fill fill) {
+        const unsigned tail = *_sq_tail;
+        const unsigned index = tail & _sq_mask;
+        io_uring_sqe& sqe = _sqes[index];
+        std::memset(&sqe, 0, sizeof sqe);
+        fill(sqe);
+        _sq_array[index] = index;
+        __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+        if (const int error = enter(1, 0, 0)) {
+            __atomic_store_n(_sq_tail, tail, __ATOMIC_RELEASE);
+            throw_io_error(error, "io_uring_enter");
+        }
+    }
+
+    // calls on_complete for every completion that is already there
+    template <class OnComplete>
+    void reap(OnComplete on_complete) {
+        unsigned head = *_cq_head;
+        while (head != __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe cqe = _cqes[head & _cq_mask];
+            __atomic_store_n(_cq_head, ++head, __ATOMIC_RELEASE);
+            on_complete(cqe);
+        }
+    }
+
+    void wait() {
+        if (const int error = enter(0, 1, IORING_ENTER_GETEVENTS))
+            throw_io_error(error, "io_uring_enter");
+    }
+};
+#endif
+
+}  // namespace detail
+
+// output to a regular file through a ring of buffers. a buffer that fills
+// up is submitted as an io_uring write (from buffers registered with the
+// kernel up front), and formatting carries on in the next one; the
+// formatting thread only waits when every buffer is still in flight. without
+// io_uring (or with use_pwrite) each buffer is written with pwrite instead.
+// output starts at the file's current offset and the offset is left at the
+// end of it by close(). format into it with format_to(sink.out(), ...).
+// write errors are reported by the next flush(), close() or buffer switch.
+class uring_file_sink : detail::buffer<char> {
+    struct slot {
+        std::size_t size = 0;
+        std::size_t done = 0;
+        off_t offset = 0;
+        bool in_flight = false;
+    };
+
+    int _fd = -1;
+    bool _owns_fd = false;
+    off_t _offset = 0;
+    uring_file_options _options;
+    char* _memory = nullptr;
+    std::vector<slot> _slots;
+    unsigned _current = 0;
+    int _error = 0;
+#if LRSTD_HAS_IO_URING
+    detail::io_uring_queue _ring;
+    bool _uring = false;
+    bool _fixed = false;
+#endif
+
+    static void grow(detail::buffer<char>& buf, std::size_t) {
+        auto& self = static_cast<uring_file_sink&>(buf);
+        self.submit_current();
+        self.next_buffer();
+    }
+
+    char* buffer_data(unsigned i) const noexcept {
+        return _memory + i * _options.buffer_size;
+    }
+
+    void init(uring_file_options options) {
+        _options = options;
+        _options.buffer_count = std::max(_options.buffer_count, 2u);
+        _options.buffer_size = std::max(_options.buffer_size, std::size_t(1));
+        _offset = ::lseek(_fd, 0, SEEK_CUR);
+        if (_offset < 0)
+            detail::throw_io_error(errno, "lseek");
+
+        _slots.resize(_options.buffer_count);
+#if LRSTD_HAS_IO_URING
+        std::vector<iovec> iov(_options.buffer_count);
+#endif
+        const std::size_t total = _options.buffer_size * _options.buffer_count;
+        if (::posix_memalign(reinterpret_cast<void**>(&_memory), 4096, total))
+            throw std::bad_alloc();
+#if LRSTD_HAS_IO_URING
+        if (!_options.use_pwrite && _ring.open(_options.buffer_count)) {
+            for (unsigned i = 0; i != _options.buffer_count; ++i)
+                iov[i] = {buffer_data(i), _options.buffer_size};
+            _fixed = _ring.register_buffers(iov.data(), _options.buffer_count);
+            // io_uring without the write opcode falls back to pwrite
+            _uring = _ring.supports(_fixed ? IORING_OP_WRITE_FIXED
+                                           : IORING_OP_WRITE);
+            if (!_uring)
+                _ring.close();
+        }
+#endif
+        this->set(buffer_data(0), _options.buffer_size);
+    }
+
+    void submit_current() {
+        if (this->size() == 0)
+            return;
+        slot& s = _slots[_current];
+        s.size = this->size();
+        s.done = 0;
+        s.offset = _offset;
+        _offset += static_cast<off_t>(s.size);
+        write(_current);
+    }
+
+    void write(unsigned i) {
+        slot& s = _slots[i];
+#if LRSTD_HAS_IO_URING
+        if (_uring) {
+            _ring.submit([&](io_uring_sqe& sqe) {
+                sqe.opcode = _fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+                sqe.fd = _fd;
+                sqe.addr = reinterpret_cast<std::uintptr_t>(buffer_data(i) +
+                                                            s.done);
+                sqe.len = static_cast<unsigned>(s.size - s.done);
+                sqe.off = static_cast<std::uint64_t>(s.offset) + s.done;
+                sqe.buf_index = static_cast<std::uint16_t>(i);
+                sqe.user_data = i;
+            });
+            s.in_flight = true;
+            return;
+        }
+#endif
+        while (s.done != s.size) {
+            const ssize_t written =
+                  ::pwrite(_fd, buffer_data(i) + s.done, s.size - s.done,
+                           s.offset + static_cast<off_t>(s.done));
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                detail::throw_io_error(errno, "pwrite");
+            }
+            s.done += static_cast<std::size_t>(written);
+        }
+    }
+
+#if LRSTD_HAS_IO_URING
+    void complete(const io_uring_cqe& cqe) {
+        const auto i = static_cast<unsigned>(cqe.user_data);
+        slot& s = _slots[i];
+        s.in_flight = false;
+        if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+            return write(i);
+        if (cqe.res < 0) {
+            _error = -cqe.res;
+            return;
+        }
+        if (cqe.res == 0) {
+            _error = EIO;
+            return;
+        }
+        s.done += static_cast<std::size_t>(cqe.res);
+        if (s.done != s.size)
+            write(i);
+    }
+
+    void reap() {
+        _ring.reap([&](const io_uring_cqe& cqe) { complete(cqe); });
+    }
+#endif
+
+    void wait_for(unsigned i) {
+#if LRSTD_HAS_IO_URING
+        if (_uring) {
+            reap();
+            while (_slots[i].in_flight) {
+                _ring.wait();
+                reap();
+            }
+        }
+#else
+        (void)i;
+#endif
+    }
+
+    void throw_if_failed() {
+        if (_error != 0)
+            detail::throw_io_error(_error, "write");
+    }
+
+    void next_buffer() {
+        const unsigned next = (_current + 1) % _options.buffer_count;
+        wait_for(next);
+        throw_if_failed();
+        _current = next;
+        this->set(buffer_data(_current), _options.buffer_size);
+        this->clear();
+    }
+
+   public:
+    explicit uring_file_sink(int fd, uring_file_options options = {})
+        : buffer<char>{&grow}, _fd{fd} {
+        init(options);
+    }
+    explicit uring_file_sink(const char* path, uring_file_options options = {})
+        : buffer<char>{&grow}, _owns_fd{true} {
+        _fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (_fd < 0)
+            detail::throw_io_error(errno, "open");
+        try {
+            init(options);
+        } catch (...) {
+            ::close(_fd);
+            throw;
+        }
+    }
+
+    // errors are only reported by an explicit close()
+    ~uring_file_sink() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    detail::buffer_iter<char> out() noexcept {
+        return detail::buffer_iter<char>(*this);
+    }
+
+    bool is_open() const noexcept { return _memory != nullptr; }
+
+    bool uses_io_uring() const noexcept {
+#if LRSTD_HAS_IO_URING
+        return _uring;
+#else
+        return false;
+#endif
+    }
+
+    // submits what has been formatted so far and waits until all of it is
+    // written
+    void flush() {
+        submit_current();
+        for (unsigned i = 0; i != _options.buffer_count; ++i)
+            wait_for(i);
+        this->clear();
+        throw_if_failed();
+    }
+
+    void close() {
+        if (!_memory)
+            return;
+        std::exception_ptr failure;
+        try {
+            flush();
+        } catch (...) {
+            failure = std::current_exception();
+        }
+#if LRSTD_HAS_IO_URING
+        if (failure && _uring) {
+            // nothing can be in flight when the buffers are freed
+            try {
+                for (unsigned i = 0; i != _options.buffer_count; ++i)
+                    wait_for(i);
+            } catch (...) {
+            }
+        }
+        _ring.close();
+#endif
+        std::free(_memory);
+        _memory = nullptr;
+        this->set(nullptr, 0);
+        ::lseek(_fd, _offset, SEEK_SET);
+        if (_owns_fd && ::close(_fd) != 0 && !failure)
+            detail::throw_io_error(errno, "close");
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+};
+
+}  // namespace lrstd
+
+#endif
@@ -0,0 +1,5 @@
+// the format_compiled library: the instantiations that format.hpp declares
+// extern when LRSTD_FORMAT_COMPILED is set
+
+#define LRSTD_FORMAT_INSTANTIATE template
+#include "format.hpp"
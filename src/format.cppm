@@ -0,0 +1,80 @@
+// the lrstd.format module: the public API of format.hpp, format_locale.hpp
+// and, where there is <unistd.h>, print.hpp. the headers are compiled once,
+// in the global module fragment, and their public names are exported from
+// there.
+
+module;
+
+#include "format.hpp"
+#include "format_locale.hpp"
+#if __has_include(<unistd.h>)
+#include "print.hpp"
+#endif
+
+export module lrstd.format;
+
+export namespace lrstd {
+
+// [format.error], [format.formatter], [format.context], [format.arguments]
+using lrstd::format_error;
+using lrstd::formatter;
+using lrstd::basic_format_parse_context;
+using lrstd::format_parse_context;
+using lrstd::wformat_parse_context;
+using lrstd::basic_format_context;
+using lrstd::format_context;
+using lrstd::wformat_context;
+using lrstd::basic_format_arg;
+using lrstd::basic_format_args;
+using lrstd::format_args;
+using lrstd::wformat_args;
+using lrstd::format_args_t;
+using lrstd::visit_format_arg;
+using lrstd::make_format_args;
+using lrstd::make_wformat_args;
+using lrstd::arg;
+using lrstd::dynamic_format_arg_store;
+
+// [format.functions]
+using lrstd::format;
+using lrstd::vformat;
+using lrstd::format_to;
+using lrstd::vformat_to;
+using lrstd::format_to_n;
+using lrstd::format_to_n_result;
+using lrstd::formatted_size;
+
+// extensions
+using lrstd::format_to_truncated;
+using lrstd::format_to_truncated_result;
+using lrstd::format_append;
+using lrstd::vformat_append;
+using lrstd::format_view;
+using lrstd::vformat_view;
+using lrstd::format_small;
+using lrstd::inline_string;
+using lrstd::overflow_policy;
+using lrstd::max_formatted_size;
+using lrstd::unbounded_formatted_size;
+using lrstd::basic_memory_buffer;
+using lrstd::memory_buffer;
+using lrstd::wmemory_buffer;
+using lrstd::inline_buffer_size;
+using lrstd::basic_chunked_formatter;
+using lrstd::chunked_formatter;
+using lrstd::wchunked_formatter;
+using lrstd::basic_callback_sink;
+using lrstd::callback_sink;
+using lrstd::wcallback_sink;
+
+#if __has_include(<unistd.h>)
+// print.hpp
+using lrstd::print;
+using lrstd::println;
+using lrstd::vprint;
+using lrstd::vprintln;
+using lrstd::format_iovec;
+using lrstd::print_buffer_size;
+#endif
+
+}  // namespace lrstd
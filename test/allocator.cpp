@@ -0,0 +1,79 @@
+#include "converter.hpp"
+#include "format_locale.hpp"
+#include "locales.hpp"
+
+#include <catch.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+
+namespace {
+std::size_t allocations = 0;
+
+template <class T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+    template <class U>
+    counting_allocator(const counting_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        ++allocations;
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    friend bool operator==(counting_allocator, counting_allocator) {
+        return true;
+    }
+    friend bool operator!=(counting_allocator, counting_allocator) {
+        return false;
+    }
+};
+}  // namespace
+
+TEMPLATE_TEST_CASE("format_with_allocator", "", char, wchar_t) {
+    using namespace lrstd;
+
+    str_fn<TestType> str;
+
+    {
+        allocations = 0;
+        counting_allocator<TestType> alloc;
+        const auto s = format(alloc, str("{:>30}|{}"), 42, str("x"));
+        static_assert(
+              std::is_same_v<std::remove_const_t<decltype(s)>,
+                             std::basic_string<TestType,
+                                               std::char_traits<TestType>,
+                                               counting_allocator<TestType>>>);
+        CHECK(s == str("                            42|x"));
+        CHECK(allocations == 1);
+
+        // longer than the scratch buffer's inline storage, so that comes
+        // from the allocator too
+        allocations = 0;
+        const std::basic_string<TestType> long_str(2000, str('a'));
+        CHECK(format(alloc, str("{}{}"), long_str, 1).size() == 2001);
+        CHECK(allocations >= 2);
+
+        CHECK(format(alloc, en_US_locale{}(), str("{:L}"), 1234) ==
+              str("1,234"));
+    }
+    {
+        // everything comes out of the monotonic resource's initial buffer
+        std::byte storage[65536];
+        std::pmr::monotonic_buffer_resource resource(
+              storage, sizeof storage, std::pmr::null_memory_resource());
+        std::pmr::polymorphic_allocator<TestType> alloc(&resource);
+        const std::basic_string<TestType> long_str(1000, str('b'));
+        const auto s = format(alloc, str("{}-{}-{}"), long_str, 7, long_str);
+        CHECK(s.size() == 2003);
+        CHECK(s.get_allocator().resource() == &resource);
+        CHECK_THROWS_AS(format(alloc, str("{:100000}"), 1), std::bad_alloc);
+    }
+}
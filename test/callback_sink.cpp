@@ -0,0 +1,56 @@
+#include "converter.hpp"
+#include "format.hpp"
+
+#include <catch.hpp>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+TEMPLATE_TEST_CASE("callback_sink", "", char, wchar_t) {
+    using namespace lrstd;
+    using view = std::basic_string_view<TestType>;
+
+    str_fn<TestType> str;
+
+    // where each chunk was, and what was in it
+    std::vector<std::pair<const TestType*, std::basic_string<TestType>>> chunks;
+    std::basic_string<TestType> result;
+    auto callback = [&](view chunk) {
+        chunks.emplace_back(chunk.data(), chunk);
+        result += chunk;
+    };
+
+    const std::basic_string<TestType> long_str(100, str('l'));
+    const std::basic_string<TestType> literal(40, str('t'));
+    const std::basic_string<TestType> fmt = literal + str("{}|{:>5}|{}|{:.3}");
+    {
+        basic_callback_sink<TestType, decltype(callback), 16> sink(callback);
+        format_to(sink.out(), fmt, 1, 23, long_str, long_str);
+        sink.flush();
+        sink.flush();
+    }
+    CHECK(result == format(fmt, 1, 23, long_str, long_str));
+    // the long literal and the long string argument went straight through
+    REQUIRE(chunks.size() == 4);
+    CHECK(chunks[0].first == fmt.data());
+    CHECK(chunks[1].second == str("1|   23|"));
+    CHECK(chunks[2].first == long_str.data());
+    CHECK(chunks[3].second == str("|lll"));
+
+    // everything else goes through the buffer, a buffer at a time
+    chunks.clear();
+    result.clear();
+    {
+        basic_callback_sink<TestType, decltype(callback), 8> sink(callback,
+                                                                 1000);
+        format_to(sink.out(), str("{:*^20}{}"), long_str.substr(0, 10), 42);
+        CHECK(result.size() == 16);
+        sink.flush();
+    }
+    CHECK(result == str("*****llllllllll*****42"));
+    CHECK(chunks.size() == 3);
+    CHECK(chunks[0].second.size() == 8);
+    CHECK(chunks[1].second.size() == 8);
+}
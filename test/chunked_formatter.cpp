@@ -0,0 +1,122 @@
+#include "converter.hpp"
+#include "format_locale.hpp"
+
+#include <catch.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+template <class CharT>
+using context_for =
+      lrstd::basic_format_context<lrstd::detail::buffer_iter<CharT>, CharT>;
+
+// fills chunks of chunk_size until done, and puts them back together
+template <class CharT>
+std::basic_string<CharT> fill_all(lrstd::basic_chunked_formatter<CharT>& f,
+                                  std::size_t chunk_size) {
+    std::basic_string<CharT> result;
+    std::vector<CharT> chunk(chunk_size);
+    for (;;) {
+        const auto r = f.fill(chunk.data(), chunk.size());
+        result.append(chunk.data(), r.size);
+        if (r.done)
+            return result;
+        CHECK(r.size == chunk_size);
+    }
+}
+}  // namespace
+
+TEMPLATE_TEST_CASE("chunked_formatter", "", char, wchar_t) {
+    using namespace lrstd;
+    using formatter_type = basic_chunked_formatter<TestType>;
+
+    str_fn<TestType> str;
+
+    const std::basic_string<TestType> long_str(1000, str('l'));
+    const auto fmt = str("{0}|{1:*^9}|{{escaped}}|{1:x}|{2}|{0:>+6}}}tail");
+    const auto store =
+          make_format_args<context_for<TestType>>(-42, 255, long_str);
+    const auto expected = format(fmt, -42, 255, long_str);
+
+    for (std::size_t chunk_size : {1, 2, 3, 7, 16, 100, 999, 1000, 5000}) {
+        formatter_type f(fmt, store);
+        CHECK(!f.done());
+        CHECK(fill_all(f, chunk_size) == expected);
+        CHECK(f.done());
+        // nothing more once it's done
+        TestType c;
+        const auto r = f.fill(&c, 1);
+        CHECK(r.size == 0);
+        CHECK(r.done);
+    }
+
+    // a chunk the exact size of the output
+    {
+        formatter_type f(fmt, store);
+        std::basic_string<TestType> chunk(expected.size(), str('?'));
+        const auto r = f.fill(chunk.data(), chunk.size());
+        CHECK(chunk == expected);
+        CHECK(r.size == expected.size());
+        CHECK((r.done || f.fill(chunk.data(), 1).size == 0));
+    }
+
+    // empty chunks don't lose anything
+    {
+        formatter_type f(fmt, store);
+        std::basic_string<TestType> result;
+        TestType chunk[4];
+        while (!f.done()) {
+            CHECK(f.fill(chunk, 0).size == 0);
+            const auto r = f.fill(chunk, 4);
+            result.append(chunk, r.size);
+        }
+        CHECK(result == expected);
+    }
+
+    {
+        formatter_type f(str(""), store);
+        CHECK(f.done());
+    }
+
+    // a field that doesn't fit is held whole, but nothing after it
+    {
+        formatter_type f(str("{2}{0}"), store);
+        TestType chunk[16];
+        CHECK(f.pending() == 0);
+        CHECK(f.fill(chunk, 16).size == 16);
+        CHECK(f.pending() == long_str.size() - 16);
+        CHECK(f.fill(chunk, 16).size == 16);
+        CHECK(f.pending() == long_str.size() - 32);
+        CHECK(fill_all(f, 16) == long_str.substr(32) + str("-42"));
+        CHECK(f.pending() == 0);
+    }
+
+    // errors come out of the fill that gets to them
+    {
+        formatter_type f(str("0123456789{2:d}"), store);
+        TestType chunk[5];
+        CHECK(f.fill(chunk, 5).size == 5);
+        CHECK(f.fill(chunk, 5).size == 5);
+        CHECK_THROWS_AS(f.fill(chunk, 5), format_error);
+    }
+    {
+        formatter_type f(str("abc{5}"), store);
+        TestType chunk[2];
+        CHECK(f.fill(chunk, 2).size == 2);
+        CHECK_THROWS_AS(fill_all(f, 2), format_error);
+    }
+}
+
+TEST_CASE("chunked_formatter_locale", "") {
+    struct sep : std::numpunct<char> {
+        char do_thousands_sep() const override { return '_'; }
+        std::string do_grouping() const override { return "\3"; }
+    };
+    const std::locale loc(std::locale::classic(), new sep);
+
+    const auto store = lrstd::make_format_args(1234567, 89);
+    lrstd::chunked_formatter f(loc, "{:L} {}", store);
+    CHECK(fill_all(f, 3) == "1_234_567 89");
+}
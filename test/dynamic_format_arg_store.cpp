@@ -0,0 +1,112 @@
+#include "converter.hpp"
+#include "format.hpp"
+#include "user_defined.hpp"
+
+#include <catch.hpp>
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+template <class CharT>
+using context_for = std::conditional_t<std::is_same_v<CharT, char>,
+                                       lrstd::format_context,
+                                       lrstd::wformat_context>;
+
+namespace {
+struct counted {
+    static inline int live = 0;
+    int value;
+    explicit counted(int v) : value{v} { ++live; }
+    counted(const counted& other) : value{other.value} { ++live; }
+    ~counted() { --live; }
+};
+}  // namespace
+
+template <class Char>
+struct lrstd::formatter<counted, Char> : lrstd::formatter<int, Char> {
+    template <class Out>
+    auto format(const counted& c, basic_format_context<Out, Char>& ctx) {
+        return formatter<int, Char>::format(c.value, ctx);
+    }
+};
+
+TEMPLATE_TEST_CASE("dynamic_format_arg_store", "", char, wchar_t) {
+    using lrstd::vformat;
+    using context = context_for<TestType>;
+    str_fn<TestType> str;
+
+    {
+        lrstd::dynamic_format_arg_store<context> store;
+        CHECK(vformat(str("empty"), store) == str("empty"));
+        store.push_back(42);
+        store.push_back(str('x'));
+        store.push_back(true);
+        store.push_back(nullptr);
+        CHECK(store.size() == 4);
+        CHECK(vformat(str("{} {} {} {}"), store) == str("42 x true 0x0"));
+        CHECK(vformat(str("{3} {2} {1} {0:>4}"), store) ==
+              str("0x0 true x   42"));
+    }
+    {
+        lrstd::dynamic_format_arg_store<context> store;
+        {
+            std::basic_string<TestType> s = str("transient");
+            store.push_back(s);
+            store.push_back(std::basic_string_view<TestType>(s).substr(0, 5));
+            store.push_back(s.c_str());
+            s.assign(s.size(), str('?'));
+        }
+        store.push_back(str("literal"));
+        store.push_back(std::basic_string<TestType>());
+        CHECK(vformat(str("{}|{}|{}|{}|{}"), store) ==
+              str("transient|trans|transient|literal|"));
+    }
+    {
+        lrstd::dynamic_format_arg_store<context> store;
+        std::basic_string<TestType> s = str("before");
+        store.push_back(std::cref(s));
+        s = str("after!");
+        CHECK(vformat(str("{}"), store) == str("after!"));
+    }
+    {
+        lrstd::dynamic_format_arg_store<context> store;
+        store.push_back(red);
+        store.push_back(counted{7});
+        CHECK(counted::live == 1);
+        counted c{8};
+        store.push_back(std::cref(c));
+        CHECK(counted::live == 2);
+        c.value = 9;
+        CHECK(vformat(str("{} {:>3} {}"), store) == str("red   7 9"));
+        store.clear();
+        CHECK(counted::live == 1);
+        CHECK(store.size() == 0);
+    }
+    CHECK(counted::live == 0);
+    {
+        // reuse after clear(), with more strings than fit in the first chunk
+        lrstd::dynamic_format_arg_store<context> store;
+        for (int round = 0; round != 3; ++round) {
+            std::basic_string<TestType> fmt, expected;
+            for (int i = 0; i != 100; ++i) {
+                std::basic_string<TestType> s(
+                      static_cast<std::size_t>(i % 7 + 1), str('a'));
+                s += std::basic_string<TestType>(str("-")) +
+                     std::basic_string<TestType>(
+                           static_cast<std::size_t>(round + 1), str('z'));
+                store.push_back(s);
+                store.push_back(i);
+                fmt += str("{}{} ");
+                expected += s + lrstd::format(str("{} "), i);
+            }
+            CHECK(vformat(fmt, store) == expected);
+            store.clear();
+        }
+    }
+    {
+        lrstd::dynamic_format_arg_store<context> store;
+        store.push_back(1);
+        CHECK_THROWS_AS(vformat(str("{} {}"), store), lrstd::format_error);
+    }
+}
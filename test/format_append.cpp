@@ -0,0 +1,69 @@
+#include "converter.hpp"
+#include "format_locale.hpp"
+#include "locales.hpp"
+#include "user_defined.hpp"
+
+#include <catch.hpp>
+
+#include <string>
+
+TEMPLATE_TEST_CASE("format_append", "", char, wchar_t) {
+    using namespace lrstd;
+
+    str_fn<TestType> str;
+
+    std::basic_string<TestType> s = str("head:");
+    format_append(s, str(" {} {:>4}|"), str("a"), 42);
+    CHECK(s == str("head: a   42|"));
+    format_append(s, str("{}{}{}"), true, str('c'), nullptr);
+    CHECK(s == str("head: a   42|truec0x0"));
+
+    // reuses the string's existing capacity
+    s.clear();
+    s.reserve(1000);
+    const TestType* const data = s.data();
+    for (int i = 0; i != 50; ++i)
+        format_append(s, str("{},"), i);
+    CHECK(s.data() == data);
+    CHECK(s.size() == 10 * 2 + 40 * 3);
+    CHECK(s.substr(0, 12) == str("0,1,2,3,4,5,"));
+
+    // more output than the estimate accounts for
+    s = str("<");
+    format_append(s, str("{:*^3000}"), str("mid"));
+    CHECK(s.size() == 3001);
+    CHECK(s.substr(1497, 6) == str("**mid*"));
+
+    s.clear();
+    std::locale::global(en_US_locale{}());
+    format_append(s, str("{:L}"), 1234567);
+    CHECK(s == str("1,234,567"));
+    format_append(s, std::locale::classic(), str(" {:L}"), 1234567);
+    CHECK(s == str("1,234,567 1234567"));
+    std::locale::global(std::locale::classic());
+
+    // a failed format leaves the string as it was
+    s = str("unchanged");
+    CHECK_THROWS_AS(format_append(s, str("{} {:d}"), 1, str("x")),
+                    format_error);
+    CHECK(s == str("unchanged"));
+}
+
+TEMPLATE_TEST_CASE("vformat_append", "", char, wchar_t) {
+    using namespace lrstd;
+    using context = std::conditional_t<std::is_same_v<TestType, char>,
+                                       format_context, wformat_context>;
+
+    str_fn<TestType> str;
+
+    std::basic_string<TestType> s = str("x=");
+    vformat_append(s, str("{}, y={}"),
+                   {make_format_args<context>(1, str("two"))});
+    CHECK(s == str("x=1, y=two"));
+
+    dynamic_format_arg_store<context> store;
+    store.push_back(red);
+    store.push_back(str("dyn"));
+    vformat_append(s, str(" {}/{}"), store);
+    CHECK(s == str("x=1, y=two red/dyn"));
+}
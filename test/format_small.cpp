@@ -0,0 +1,48 @@
+#include "converter.hpp"
+#include "format.hpp"
+
+#include <catch.hpp>
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<lrstd::inline_string<char, 16>>);
+static_assert(std::is_trivially_copyable_v<lrstd::inline_string<wchar_t, 3>>);
+
+TEMPLATE_TEST_CASE("format_small", "", char, wchar_t) {
+    using namespace lrstd;
+
+    str_fn<TestType> str;
+
+    {
+        const auto s = format_small<16>(str("id-{:04}-{}"), 42, str("ab"));
+        CHECK(s.view() == str("id-0042-ab"));
+        CHECK(s.size() == 10);
+        CHECK(s.c_str()[s.size()] == TestType());
+        CHECK(decltype(s)::capacity() == 16);
+        const std::basic_string_view<TestType> sv = s;
+        CHECK(sv == str("id-0042-ab"));
+    }
+    {
+        // exactly full
+        const auto s = format_small<4>(str("{}{}"), 12, 34);
+        CHECK(s.view() == str("1234"));
+        CHECK(format_small<4>(str("")).empty());
+    }
+    {
+        CHECK_THROWS_AS(format_small<4>(str("{}"), 12345), format_error);
+        const auto s =
+              format_small<4, overflow_policy::truncate>(str("{}"), 12345);
+        CHECK(s.view() == str("1234"));
+        CHECK(s.c_str()[4] == TestType());
+    }
+    {
+        const auto a = format_small<8>(str("{:>5}"), true);
+        auto b = a;
+        CHECK(b.view() == str(" true"));
+        b = format_small<8>(str("{}"), str('x'));
+        CHECK(b.view() == str("x"));
+        CHECK(a.view() == str(" true"));
+    }
+}
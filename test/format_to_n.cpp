@@ -1,5 +1,5 @@
 #include "converter.hpp"
-#include "format.hpp"
+#include "format_locale.hpp"
 #include "locales.hpp"
 #include "user_defined.hpp"
 
@@ -35,6 +35,14 @@ TEMPLATE_TEST_CASE("format_to_n", "", char, wchar_t) {
             CHECK(sv(chars) == str("the system is no"));
         }
     }
+    {
+        std::vector<TestType> chars(8, str('.'));
+        auto result = format_to_n(chars.begin() + 1, 5, str("{}{:*^7}"),
+                                  str("to"), str("xy"));
+        CHECK(result.size == 9);
+        CHECK(result.out == chars.begin() + 6);
+        CHECK(sv(chars) == str(".to**x.."));
+    }
     {
         std::vector<TestType> chars;
         {
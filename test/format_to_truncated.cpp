@@ -0,0 +1,100 @@
+#include "converter.hpp"
+#include "format.hpp"
+
+#include <catch.hpp>
+
+#include <array>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+struct noisy {
+    static inline int formatted = 0;
+};
+}  // namespace
+
+template <class Char>
+struct lrstd::formatter<noisy, Char> {
+    constexpr auto parse(basic_format_parse_context<Char>& pc) {
+        return pc.begin();
+    }
+    template <class Out>
+    auto format(const noisy&, basic_format_context<Out, Char>& ctx) {
+        ++noisy::formatted;
+        auto out = ctx.out();
+        *out++ = Char('n');
+        return out;
+    }
+};
+
+TEMPLATE_TEST_CASE("format_to_truncated", "", char, wchar_t) {
+    using namespace lrstd;
+
+    str_fn<TestType> str;
+    SV<TestType> sv;
+
+    {
+        std::array<TestType, 16> chars{};
+        auto result = format_to_truncated(chars.begin(), 11,
+                                          str("unavoidable paradigm"));
+        CHECK(result.truncated);
+        CHECK(result.out == chars.begin() + 11);
+        CHECK(sv(chars) == str("unavoidable"));
+    }
+    {
+        std::array<TestType, 16> chars{};
+        auto result = format_to_truncated(chars.data(), 16, str("{:>6}|{}"),
+                                          42, str("fits"));
+        CHECK(!result.truncated);
+        CHECK(result.out == chars.data() + 11);
+        CHECK(sv(chars) == str("    42|fits"));
+    }
+    {
+        // exactly n characters isn't a truncation
+        std::vector<TestType> chars(4, str('.'));
+        auto result =
+              format_to_truncated(chars.begin(), 4, str("{}{}"), 12, 34);
+        CHECK(!result.truncated);
+        CHECK(result.out == chars.end());
+        CHECK(sv(chars) == str("1234"));
+    }
+    {
+        // a long argument is cut to what fits
+        const std::basic_string<TestType> payload(4096, str('p'));
+        std::basic_string<TestType> chars;
+        auto result = format_to_truncated(std::back_inserter(chars), 8,
+                                          str("[{:^5000}]"), payload);
+        CHECK(result.truncated);
+        CHECK(chars == str("[       "));
+    }
+    {
+        std::deque<TestType> chars;
+        auto result = format_to_truncated(std::back_inserter(chars), 5,
+                                          str("{}-{}"), str("abc"), 123);
+        CHECK(result.truncated);
+        CHECK(std::basic_string<TestType>(chars.begin(), chars.end()) ==
+              str("abc-1"));
+    }
+    {
+        // nothing past the cut is formatted or even parsed
+        noisy::formatted = 0;
+        std::array<TestType, 8> chars{};
+        auto result = format_to_truncated(chars.begin(), 3,
+                                          str("{}{}{}{}{}|{:invalid"),
+                                          noisy{}, noisy{}, noisy{}, noisy{},
+                                          noisy{});
+        CHECK(result.truncated);
+        CHECK(noisy::formatted == 4);
+        CHECK(sv(chars) == str("nnn"));
+    }
+    {
+        std::array<TestType, 4> chars{};
+        auto result = format_to_truncated(chars.begin(), 0, str("{}"), 1);
+        CHECK(result.truncated);
+        CHECK(result.out == chars.begin());
+        result = format_to_truncated(chars.begin(), -1, str(""));
+        CHECK(!result.truncated);
+    }
+}
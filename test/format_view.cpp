@@ -0,0 +1,77 @@
+#include "converter.hpp"
+#include "format.hpp"
+
+#include <catch.hpp>
+
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace {
+// formats itself with another call to lrstd::format or lrstd::format_view
+template <bool View>
+struct nested {
+    int value;
+};
+}  // namespace
+
+template <bool View, class Char>
+struct lrstd::formatter<nested<View>, Char> {
+    constexpr auto parse(basic_format_parse_context<Char>& pc) {
+        return pc.begin();
+    }
+    template <class Out>
+    auto format(const nested<View>& n, basic_format_context<Out, Char>& ctx) {
+        std::basic_string<Char> s;
+        if constexpr (std::is_same_v<Char, char>)
+            s = View ? std::string(lrstd::format_view("<{}>", n.value))
+                     : lrstd::format("<{}>", n.value);
+        else
+            s = View ? std::wstring(lrstd::format_view(L"<{}>", n.value))
+                     : lrstd::format(L"<{}>", n.value);
+        return std::copy(s.begin(), s.end(), ctx.out());
+    }
+};
+
+TEMPLATE_TEST_CASE("format_view", "", char, wchar_t) {
+    using namespace lrstd;
+
+    str_fn<TestType> str;
+
+    auto v = format_view(str("{}-{:>4}"), str("id"), 7);
+    CHECK(v == str("id-   7"));
+    // reuses the same storage from call to call
+    const TestType* const data = v.data();
+    v = format_view(str("{}"), 12345);
+    CHECK(v == str("12345"));
+    CHECK(v.data() == data);
+
+    const std::basic_string<TestType> long_str(100000, str('x'));
+    v = format_view(str("{}{}"), long_str, 1);
+    CHECK(v.size() == 100001);
+    CHECK(v.back() == str('1'));
+    v = format_view(str("{}"), 2);
+    CHECK(v == str("2"));
+
+    // plain format calls inside a formatter still work, whichever buffer
+    // format uses
+    CHECK(format(str("{}|{}"), nested<false>{1}, 2) == str("<1>|2"));
+    CHECK(format_view(str("{}|{}"), nested<false>{1}, 2) == str("<1>|2"));
+    CHECK(format(str("{}"), nested<true>{3}) == str("<3>"));
+    // but a view can't be taken while the buffer is being formatted into
+    CHECK_THROWS_AS(format_view(str("{}"), nested<true>{4}), format_error);
+    CHECK(format_view(str("ok")) == str("ok"));
+
+    const std::basic_string_view<TestType> first = format_view(str("main"));
+    std::thread([&] {
+        CHECK(format_view(str("{}"), 99) == str("99"));
+    }).join();
+    CHECK(first == str("main"));
+
+    CHECK(vformat_view(str("{}{}"), {make_format_args<
+                                          std::conditional_t<
+                                                std::is_same_v<TestType, char>,
+                                                format_context,
+                                                wformat_context>>(1, 2)}) ==
+          str("12"));
+}
@@ -1,8 +1,9 @@
 #include "converter.hpp"
-#include "format.hpp"
+#include "format_locale.hpp"
 #include "locales.hpp"
 #include "user_defined.hpp"
 
+#include <climits>
 #include <string>
 #include <string_view>
 
@@ -74,4 +75,57 @@ TEMPLATE_TEST_CASE("formatted_size", "", char, wchar_t) {
     }
     { CHECK(formatted_size(str("{}"), red) == 3); }
     { CHECK(formatted_size(str("{0:{1}}"), S{42}, 10) == 10); }
+    {
+        const std::basic_string<TestType> literal(10000, str('.'));
+        CHECK(formatted_size(literal) == 10000);
+        CHECK(formatted_size(str("{}{:*^100000}"), literal, str('x')) ==
+              110000);
+        CHECK(formatted_size(str("{:>5}{}"), literal, literal) == 20000);
+    }
+}
+
+TEMPLATE_TEST_CASE("formatted_size_matches_format", "", char, wchar_t) {
+    str_fn<TestType> str;
+
+    const std::basic_string_view<TestType> fmts[] = {
+          str("{}"),      str("{:b}"),     str("{:#o}"),  str("{:#x}"),
+          str("{:+d}"),   str("{: 020}"),  str("{:L}"),   str("{:*^30X}"),
+          str("{:#B}"),   str("{:>3d}"),   str("{:+#015Lx}")};
+    const std::locale locales[] = {en_US_locale{}(), en_US_funky_locale{}(),
+                                   embedded_char_max_locale{}()};
+    auto check = [&](auto value) {
+        for (const auto& loc : locales) {
+            for (auto fmt : fmts) {
+                CHECK(lrstd::formatted_size(loc, fmt, value) ==
+                      lrstd::format(loc, fmt, value).size());
+            }
+        }
+    };
+    const long long signed_values[] = {0,   1,    -1,  7,   8,   9,
+                                       10,  -15,  16,  99,  100, -128,
+                                       255, 256,  999, 1000, 123456789,
+                                       LLONG_MIN, LLONG_MAX};
+    for (long long i : signed_values) {
+        check(i);
+        check(static_cast<int>(i));
+    }
+    const unsigned long long unsigned_values[] = {
+          0, 1, 9, 10, 4294967295ull, 4294967296ull, 9999999999999999999ull,
+          10000000000000000000ull, ULLONG_MAX};
+    for (unsigned long long i : unsigned_values)
+        check(i);
+
+    for (auto fmt : {str("{}"), str("{:>8}"), str("{:d}"), str("{:#x}")}) {
+        CHECK(lrstd::formatted_size(fmt, true) ==
+              lrstd::format(fmt, true).size());
+        CHECK(lrstd::formatted_size(fmt, str('c')) ==
+              lrstd::format(fmt, str('c')).size());
+    }
+    int x;
+    for (const void* p : {static_cast<const void*>(nullptr),
+                          static_cast<const void*>(&x)}) {
+        CHECK(lrstd::formatted_size(str("{}"), p) ==
+              lrstd::format(str("{}"), p).size());
+        CHECK(lrstd::formatted_size(str("{:>40}"), p) == 40);
+    }
 }
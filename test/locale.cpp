@@ -1,4 +1,4 @@
-#include "format.hpp"
+#include "format_locale.hpp"
 
 #include "converter.hpp"
 #include "locales.hpp"
@@ -434,3 +434,34 @@ TEMPLATE_TEST_CASE("bool_cppreference_examples", "", char, wchar_t) {
         CHECK(format(loc, str("{:>5L}"), false) == str(" faux"));
     }
 }
+
+namespace {
+struct thousands_sep {};
+}  // namespace
+
+template <class CharT>
+struct lrstd::formatter<thousands_sep, CharT> {
+    constexpr auto parse(basic_format_parse_context<CharT>& ctx) {
+        return ctx.begin();
+    }
+    template <class Out>
+    Out format(thousands_sep, basic_format_context<Out, CharT>& ctx) {
+        auto out = ctx.out();
+        *out++ = std::use_facet<std::numpunct<CharT>>(ctx.locale())
+                       .thousands_sep();
+        return out;
+    }
+};
+
+TEMPLATE_TEST_CASE("context_locale", "", char, wchar_t) {
+    using lrstd::format;
+    using charT = TestType;
+    str_fn<charT> str;
+
+    CHECK(format(embedded_null_locale{}(), str("{}"), thousands_sep{}) ==
+          str("%"));
+    std::locale::global(embedded_null_locale{}());
+    CHECK(format(str("{}"), thousands_sep{}) == str("%"));
+    std::locale::global(std::locale::classic());
+    CHECK(format(str("{}"), thousands_sep{}) == str(","));
+}
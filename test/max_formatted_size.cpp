@@ -0,0 +1,65 @@
+#include "converter.hpp"
+#include "format_locale.hpp"
+#include "locales.hpp"
+#include "user_defined.hpp"
+
+#include <catch.hpp>
+
+#include <climits>
+#include <string>
+#include <string_view>
+
+using lrstd::max_formatted_size;
+using lrstd::unbounded_formatted_size;
+
+static_assert(max_formatted_size("") == 0);
+static_assert(max_formatted_size("literal {{}}") == 10);
+static_assert(max_formatted_size<int>("{}") == 11);
+static_assert(max_formatted_size<unsigned long long>("{}") == 21);
+static_assert(max_formatted_size<short>("{:#b}") == 19);
+static_assert(max_formatted_size<int>("{:*^40}") == 40);
+static_assert(max_formatted_size<int>("{:4}") == 11);
+static_assert(max_formatted_size<bool, char>("{} {}") == 7);
+static_assert(max_formatted_size<const void*>("{}") == sizeof(void*) * 2 + 2);
+static_assert(max_formatted_size<char[6]>("[{}]") == 7);
+static_assert(max_formatted_size<std::string>("{:.3}") == 3);
+static_assert(max_formatted_size<std::string>("{:>8.3}") == 8);
+static_assert(max_formatted_size<std::string>("{}") == unbounded_formatted_size);
+static_assert(max_formatted_size<const char*>("x{}") ==
+              unbounded_formatted_size);
+static_assert(max_formatted_size<int, int>("{:{}}") ==
+              unbounded_formatted_size);
+static_assert(max_formatted_size<S>("{}") == unbounded_formatted_size);
+static_assert(max_formatted_size<int, unsigned char>("{1}{0}") == 15);
+static_assert(max_formatted_size<lrstd::detail::named_arg<char, short>,
+                                 long long>("{x}") == 20);
+static_assert(max_formatted_size<int>(L"{:L}") == 20);
+
+TEMPLATE_TEST_CASE("max_formatted_size", "", char, wchar_t) {
+    str_fn<TestType> str;
+
+    // actual output never exceeds the bound, even for extreme values
+    const std::basic_string_view<TestType> fmts[] = {
+          str("{}"),   str("{:b}"),      str("{:#o}"),    str("{:+#X}"),
+          str("{:L}"), str("{:>30}|"),   str("{:#015x}"), str("{{{:#B}}}")};
+    auto check = [&](auto value) {
+        using T = decltype(value);
+        for (auto fmt : fmts) {
+            const std::size_t bound = max_formatted_size<T>(fmt);
+            CHECK(lrstd::formatted_size(fmt, value) <= bound);
+            CHECK(lrstd::formatted_size(embedded_char_max_locale{}(), fmt,
+                                        value) <= bound);
+        }
+    };
+    check(LLONG_MIN);
+    check(LLONG_MAX);
+    check(ULLONG_MAX);
+    check(INT_MIN);
+    check(static_cast<short>(SHRT_MIN));
+    check(static_cast<unsigned char>(UCHAR_MAX));
+
+    CHECK(max_formatted_size<int>(str("{:s}")) == 11);
+    CHECK_THROWS_AS(max_formatted_size<int>(str("{1}")), lrstd::format_error);
+    CHECK_THROWS_AS(max_formatted_size<int>(str("{")), lrstd::format_error);
+    CHECK_THROWS_AS(max_formatted_size<int>(str("}")), lrstd::format_error);
+}
@@ -0,0 +1,46 @@
+#include "converter.hpp"
+#include "format.hpp"
+
+#include <catch.hpp>
+
+#include <string>
+#include <string_view>
+
+TEMPLATE_TEST_CASE("memory_buffer", "", char, wchar_t) {
+    using buffer = lrstd::basic_memory_buffer<TestType, 8>;
+    str_fn<TestType> str;
+
+    buffer buf;
+    CHECK(buf.size() == 0);
+    CHECK(buf.capacity() == 8);
+    const TestType* const inline_data = buf.data();
+
+    const std::basic_string_view<TestType> s = str("0123456");
+    buf.append(s.data(), s.data() + s.size());
+    buf.push_back(str('7'));
+    CHECK(buf.data() == inline_data);
+    buf.push_back(str('8'));
+    CHECK(buf.data() != inline_data);
+    CHECK(buf.capacity() >= 9);
+    buf.append(3, str('x'));
+    CHECK(std::basic_string_view<TestType>(buf.data(), buf.size()) ==
+          str("012345678xxx"));
+
+    buf.clear();
+    CHECK(buf.size() == 0);
+    buf.resize(100);
+    CHECK(buf.size() == 100);
+    CHECK(buf.capacity() >= 100);
+}
+
+TEMPLATE_TEST_CASE("format_long_output", "", char, wchar_t) {
+    str_fn<TestType> str;
+
+    // outputs that don't fit the inline storage of vformat's buffer
+    const std::basic_string<TestType> long_str(700, str('s'));
+    CHECK(lrstd::format(str("{}|{}"), long_str, long_str) ==
+          long_str + str("|") + long_str);
+    CHECK(lrstd::format(str("{:*^1000}"), str("mid")) ==
+          std::basic_string<TestType>(498, str('*')) + str("mid") +
+                std::basic_string<TestType>(499, str('*')));
+}
@@ -0,0 +1,66 @@
+#include "mmap_file_sink.hpp"
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace {
+std::string temp_path() {
+    char path[] = "/tmp/lrstd_mmap_XXXXXX";
+    const int fd = ::mkstemp(path);
+    REQUIRE(fd >= 0);
+    ::close(fd);
+    return path;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+}  // namespace
+
+TEST_CASE("mmap_file_sink", "") {
+    const std::string path = temp_path();
+
+    std::string expected;
+    {
+        lrstd::mmap_file_options options;
+        // grows a page at a time
+        options.chunk_size = 1;
+        options.sync_behind = true;
+        lrstd::mmap_file_sink sink(path, options);
+        CHECK(sink.is_open());
+        for (int i = 0; i < 2000; ++i) {
+            lrstd::format_to(sink.out(), "{:>5}|{:x}\n", i, i);
+            expected += lrstd::format("{:>5}|{:x}\n", i, i);
+        }
+        const std::string long_str(100000, 'z');
+        lrstd::format_to(sink.out(), "{}", long_str);
+        expected += long_str;
+        CHECK(sink.size() == expected.size());
+        sink.close();
+        CHECK(!sink.is_open());
+        sink.close();
+    }
+    CHECK(read_file(path) == expected);
+
+    // closed by the destructor
+    {
+        lrstd::mmap_file_sink sink(path);
+        lrstd::format_to(sink.out(), "{} {}", "short", 1);
+    }
+    CHECK(read_file(path) == "short 1");
+
+    std::remove(path.c_str());
+
+    CHECK_THROWS_AS(lrstd::mmap_file_sink("/nonexistent/dir/file"),
+                    std::system_error);
+}
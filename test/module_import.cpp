@@ -0,0 +1,34 @@
+// checks that the lrstd.format module can be imported and used, including
+// a formatter specialized by its user. not part of format_test, which is
+// C++17 and includes the headers.
+
+#include <iterator>
+#include <string>
+#include <string_view>
+
+import lrstd.format;
+
+namespace {
+struct point {
+    int x, y;
+};
+}  // namespace
+
+template <class CharT>
+struct lrstd::formatter<point, CharT> : lrstd::formatter<int, CharT> {
+    template <class Out>
+    Out format(point p, basic_format_context<Out, CharT>& ctx) {
+        auto out = formatter<int, CharT>::format(p.x, ctx);
+        *out++ = CharT(',');
+        ctx.advance_to(out);
+        return formatter<int, CharT>::format(p.y, ctx);
+    }
+};
+
+int main() {
+    std::string s = lrstd::format("{:>4}|{}|{:#x}", 42, std::string_view("ab"),
+                                  255);
+    lrstd::format_to(std::back_inserter(s), "|{}", point{1, 2});
+    const std::wstring w = lrstd::format(L"{}", point{3, 4});
+    return s == "  42|ab|0xff|1,2" && w == L"3,4" ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include "converter.hpp"
+#include "format.hpp"
+#include "user_defined.hpp"
+
+#include <catch.hpp>
+
+#include <string>
+
+TEMPLATE_TEST_CASE("named_args", "", char, wchar_t) {
+    using lrstd::arg;
+    using lrstd::format;
+    str_fn<TestType> str;
+
+    CHECK(format(str("{name}"), arg(str("name"), 42)) == str("42"));
+    CHECK(format(str("{a}{b}{a}"), arg(str("a"), str('x')),
+                 arg(str("b"), str("yz"))) == str("xyzx"));
+    CHECK(format(str("{_x1:>4}|{y_:<3}|"), arg(str("y_"), true),
+                 arg(str("_x1"), 7)) == str("   7|true|"));
+    CHECK(format(str("{0}-{id}-{1}"), str("a"), str("b"),
+                 arg(str("id"), red)) == str("a-red-b"));
+    CHECK(format(str("{id} {id:*^5}"), arg(str("id"), 3)) == str("3 **3**"));
+
+    // named arguments are also positional arguments, and referring to them by
+    // name doesn't affect automatic indexing
+    CHECK(format(str("{}{x}{}"), arg(str("x"), 1), 2) == str("112"));
+    CHECK(format(str("{1}{x}{0}"), arg(str("x"), 1), 2) == str("211"));
+
+    {
+        // more names than fit a small argument store
+        CHECK(format(str("{k}{j}{i}{h}{g}{f}{e}{d}{c}{b}{a}{l}{m}{n}{o}{p}{q}"),
+                     arg(str("a"), 0), arg(str("b"), 1), arg(str("c"), 2),
+                     arg(str("d"), 3), arg(str("e"), 4), arg(str("f"), 5),
+                     arg(str("g"), 6), arg(str("h"), 7), arg(str("i"), 8),
+                     arg(str("j"), 9), arg(str("k"), 10), arg(str("l"), 11),
+                     arg(str("m"), 12), arg(str("n"), 13), arg(str("o"), 14),
+                     arg(str("p"), 15), arg(str("q"), 16)) ==
+              str("109876543210111213141516"));
+    }
+
+    CHECK_THROWS_AS(format(str("{nope}"), arg(str("name"), 42)),
+                    lrstd::format_error);
+    CHECK_THROWS_AS(format(str("{name}"), 42), lrstd::format_error);
+    CHECK_THROWS_AS(format(str("{name!}"), arg(str("name"), 42)),
+                    lrstd::format_error);
+    CHECK_THROWS_AS(format(str("{x}{x}"), arg(str("x"), 1), arg(str("x"), 2)),
+                    lrstd::format_error);
+    CHECK_THROWS_AS(format(str("{9x}"), arg(str("x"), 1)), lrstd::format_error);
+}
+
+TEMPLATE_TEST_CASE("named_args_dynamic_store", "", char, wchar_t) {
+    using lrstd::arg;
+    using context = std::conditional_t<std::is_same_v<TestType, char>,
+                                       lrstd::format_context,
+                                       lrstd::wformat_context>;
+    str_fn<TestType> str;
+
+    lrstd::dynamic_format_arg_store<context> store;
+    {
+        std::basic_string<TestType> name = str("column");
+        std::basic_string<TestType> value = str("value");
+        store.push_back(arg(name.c_str(), value));
+        store.push_back(arg(str("n"), 5));
+    }
+    store.push_back(str("positional"));
+    CHECK(lrstd::vformat(str("{column}={n} {2} {0}"), store) ==
+          str("value=5 positional value"));
+    CHECK_THROWS_AS(store.push_back(arg(str("n"), 6)), lrstd::format_error);
+    CHECK(store.size() == 3);
+
+    store.clear();
+    store.push_back(arg(str("n"), 6));
+    CHECK(lrstd::vformat(str("{n}"), store) == str("6"));
+    CHECK_THROWS_AS(lrstd::vformat(str("{column}"), store),
+                    lrstd::format_error);
+}
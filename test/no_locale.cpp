@@ -0,0 +1,22 @@
+// leaves <locale> out of format.hpp. the rest of the test program includes
+// format_locale.hpp, so 'L' without a locale follows the global locale here
+// as well.
+#define LRSTD_FORMAT_NO_LOCALE true
+
+#include "converter.hpp"
+#include "format.hpp"
+#include "locales.hpp"
+
+#include <catch.hpp>
+
+TEMPLATE_TEST_CASE("no_locale", "", char, wchar_t) {
+    using lrstd::format;
+    str_fn<TestType> str;
+
+    CHECK(format(str("{:L}"), 1234567) == str("1234567"));
+    std::locale::global(en_US_locale{}());
+    CHECK(format(str("{:L}"), 1234567) == str("1,234,567"));
+    CHECK(format(str("{:L}"), true) == str("true"));
+    std::locale::global(std::locale::classic());
+    CHECK(format(str("{:L}"), 1234567) == str("1234567"));
+}
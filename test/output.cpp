@@ -4,6 +4,10 @@
 #include <catch.hpp>
 
 #include <array>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -22,6 +26,65 @@ TEMPLATE_TEST_CASE("output_to_array", "", char, wchar_t) {
     CHECK(sv(chars) == str("the system is now free from error"));
 }
 
+TEMPLATE_TEST_CASE("output_to_contiguous_iterators", "", char, wchar_t) {
+    using namespace lrstd;
+
+    SV<TestType> sv;
+    str_fn<TestType> str;
+    {
+        std::vector<TestType> chars(16, str('.'));
+        CHECK(format_to(chars.begin() + 2, str("{:>4}|{}"), 42, str("ab")) ==
+              chars.begin() + 9);
+        CHECK(sv(chars) == str("..  42|ab......."));
+    }
+    {
+        std::basic_string<TestType> chars(16, str('.'));
+        CHECK(format_to(chars.begin() + 1, str("{:_<5}"), true) ==
+              chars.begin() + 6);
+        CHECK(chars == str(".true_.........."));
+        CHECK(format_to(chars.begin(), str("")) == chars.begin());
+    }
+}
+
+TEMPLATE_TEST_CASE("output_to_buffered_iterators", "", char, wchar_t) {
+    using namespace lrstd;
+
+    str_fn<TestType> str;
+    {
+        std::basic_ostringstream<TestType> stream;
+        std::ostreambuf_iterator<TestType> out(stream);
+        out = format_to(out, str("{:>5}|{}|"), 42, str("up"));
+        *out++ = str('!');
+        CHECK(stream.str() == str("   42|up|!"));
+    }
+    {
+        std::deque<TestType> chars;
+        format_to(std::back_inserter(chars), str("{:*^6}{}"), str("ab"), 9);
+        CHECK(std::basic_string<TestType>(chars.begin(), chars.end()) ==
+              str("**ab**9"));
+    }
+    {
+        // more output than fits in the buffer in front of the iterator
+        const std::basic_string<TestType> long_str(300, str('s'));
+        std::list<TestType> chars;
+        format_to(std::back_inserter(chars), str("{}{:-^601}{}"), long_str,
+                  str('|'), long_str);
+        const std::basic_string<TestType> expected =
+              long_str + std::basic_string<TestType>(300, str('-')) +
+              str("|") + std::basic_string<TestType>(300, str('-')) + long_str;
+        CHECK(std::basic_string<TestType>(chars.begin(), chars.end()) ==
+              expected);
+    }
+    {
+        std::deque<TestType> chars;
+        const auto result = format_to_n(std::back_inserter(chars), 4,
+                                        str("{}-{}"), 123, 456);
+        CHECK(result.size == 7);
+        CHECK(std::basic_string<TestType>(chars.begin(), chars.end()) ==
+              str("123-"));
+    }
+}
+
 TEMPLATE_TEST_CASE("output", "", char, wchar_t) {
     using namespace std::string_view_literals;
     using namespace lrstd;
@@ -44,6 +107,16 @@ TEMPLATE_TEST_CASE("output", "", char, wchar_t) {
         format_to(std::back_inserter(chars), str(" engraves its {}"),
                   str("name"));
         CHECK(chars == str("the radiant sun engraves its name"));
+        chars.clear();
+        format_to(std::back_inserter(chars), str("{:-^9}|{:>3}"), str("sun"),
+                  str('x'));
+        CHECK(chars == str("---sun---|  x"));
+    }
+    {
+        std::vector<TestType> chars;
+        format_to(std::back_inserter(chars), str("{:.<6}{}"), 42,
+                  str("radiant"));
+        CHECK(sv(chars) == str("42....radiant"));
     }
     {
         std::basic_string<TestType> chars;
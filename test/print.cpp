@@ -0,0 +1,130 @@
+#include "print.hpp"
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+std::string read_back(std::FILE* file) {
+    std::rewind(file);
+    std::string contents;
+    char buf[1024];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof buf, file)) != 0)
+        contents.append(buf, n);
+    return contents;
+}
+
+std::string read_all(int fd) {
+    std::string contents;
+    char buf[1024];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof buf)) > 0)
+        contents.append(buf, static_cast<std::size_t>(n));
+    return contents;
+}
+
+// hands formatter<string_view> a string that's gone once format returns
+struct temporary_text {
+    std::size_t size;
+};
+}  // namespace
+
+template <>
+struct lrstd::formatter<temporary_text> : lrstd::formatter<std::string_view> {
+    template <class Out>
+    auto format(temporary_text t, lrstd::basic_format_context<Out, char>& fc) {
+        return formatter<std::string_view>::format(std::string(t.size, 't'),
+                                                   fc);
+    }
+};
+
+TEST_CASE("print_file", "") {
+    std::FILE* const file = std::tmpfile();
+    REQUIRE(file);
+
+    lrstd::print(file, "{}-{:>4}|", "id", 42);
+    lrstd::println(file, "{}", true);
+    lrstd::println(file, "");
+    // more than fits in the print buffer at once
+    const std::string long_str(10000, 'x');
+    lrstd::print(file, "{}{}", long_str, long_str);
+    std::fflush(file);
+
+    CHECK(read_back(file) == "id-  42|true\n\n" + long_str + long_str);
+    std::fclose(file);
+}
+
+TEST_CASE("print_fd", "") {
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+
+    lrstd::print(fds[1], "{} {}", 1, "two");
+    lrstd::println(fds[1], "{:*^7}", "3");
+    const std::string long_str(20000, 'y');
+    lrstd::print(fds[1], "{}", long_str);
+    ::close(fds[1]);
+
+    CHECK(read_all(fds[0]) == "1 two***3***\n" + long_str);
+    ::close(fds[0]);
+}
+
+TEST_CASE("print_errors", "") {
+    CHECK_THROWS_AS(lrstd::print(-1, "{}", 1), std::system_error);
+
+    std::FILE* const file = std::fopen("/dev/null", "r");
+    REQUIRE(file);
+    CHECK_THROWS_AS(lrstd::println(file, "{}", 1), std::system_error);
+    std::fclose(file);
+
+    // format errors come through as usual
+    std::FILE* const tmp = std::tmpfile();
+    REQUIRE(tmp);
+    CHECK_THROWS_AS(lrstd::print(tmp, "{:d}", "x"), lrstd::format_error);
+    std::fclose(tmp);
+}
+
+TEST_CASE("format_iovec", "") {
+    const std::string head(100, 'h');
+    const std::string body(200, 'b');
+    const std::string fmt = head + "{}:{:>5}|{}|{:.150}";
+
+    lrstd::format_iovec iov;
+    lrstd::format_to(iov.out(), fmt, 42, "ab", body, body);
+    const auto vecs = iov.iovecs();
+    REQUIRE(vecs.size() == 5);
+    // the literal text and long strings are referred to in place
+    CHECK(vecs[0].iov_base == fmt.data());
+    CHECK(vecs[0].iov_len == 100);
+    CHECK(vecs[1].iov_len == 9);
+    CHECK(vecs[2].iov_base == body.data());
+    CHECK(vecs[3].iov_len == 1);
+    CHECK(vecs[4].iov_base == body.data());
+    CHECK(vecs[4].iov_len == 150);
+    CHECK(iov.size() == 100 + 9 + 200 + 1 + 150);
+
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    iov.write(fds[1]);
+    ::close(fds[1]);
+    CHECK(read_all(fds[0]) ==
+          head + "42:   ab|" + body + "|" + body.substr(0, 150));
+    ::close(fds[0]);
+
+    // text that doesn't outlive the call, and short text, is copied
+    iov.clear();
+    lrstd::format_to(iov.out(), "{}{}", temporary_text{300}, "short");
+    REQUIRE(iov.iovecs().size() == 1);
+    CHECK(iov.size() == 305);
+
+    lrstd::format_iovec no_borrowing(std::size_t(-1));
+    lrstd::format_to(no_borrowing.out(), fmt, 1, "", body, body);
+    CHECK(no_borrowing.iovecs().size() == 1);
+
+    CHECK_THROWS_AS(iov.write(-1), std::system_error);
+}
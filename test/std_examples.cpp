@@ -1,4 +1,4 @@
-#include "format.hpp"
+#include "format_locale.hpp"
 
 #include "converter.hpp"
 #include "locales.hpp"
@@ -19,3 +19,7 @@
 #include "format.hpp"
 
 #include "format.hpp"
+
+#include "format_locale.hpp"
+
+#include "format_locale.hpp"
@@ -0,0 +1,89 @@
+#include "uring_file_sink.hpp"
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+std::string temp_path() {
+    char path[] = "/tmp/lrstd_uring_XXXXXX";
+    const int fd = ::mkstemp(path);
+    REQUIRE(fd >= 0);
+    ::close(fd);
+    return path;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+}  // namespace
+
+TEST_CASE("uring_file_sink", "") {
+    const std::string path = temp_path();
+
+    for (const bool use_pwrite : {false, true}) {
+        lrstd::uring_file_options options;
+        // small enough that the ring wraps around many times
+        options.buffer_size = 4096;
+        options.buffer_count = 4;
+        options.use_pwrite = use_pwrite;
+
+        std::string expected;
+        {
+            lrstd::uring_file_sink sink(path.c_str(), options);
+            CHECK(sink.is_open());
+            if (use_pwrite)
+                CHECK(!sink.uses_io_uring());
+            for (int i = 0; i < 5000; ++i) {
+                lrstd::format_to(sink.out(), "{:>5}|{:#x}\n", i, i);
+                expected += lrstd::format("{:>5}|{:#x}\n", i, i);
+            }
+            const std::string long_str(50000, 'q');
+            lrstd::format_to(sink.out(), "{}", long_str);
+            expected += long_str;
+            sink.flush();
+            CHECK(read_file(path) == expected);
+            lrstd::format_to(sink.out(), "{}", "end");
+            expected += "end";
+            sink.close();
+            CHECK(!sink.is_open());
+            sink.close();
+        }
+        CHECK(read_file(path) == expected);
+    }
+
+    // picks up at the descriptor's offset, and leaves it after the output
+    const int fd = ::open(path.c_str(), O_WRONLY | O_TRUNC);
+    REQUIRE(fd >= 0);
+    REQUIRE(::write(fd, "head|", 5) == 5);
+    {
+        lrstd::uring_file_sink sink(fd);
+        lrstd::format_to(sink.out(), "{}-{}", 1, 2);
+    }
+    REQUIRE(::write(fd, "|tail", 5) == 5);
+    ::close(fd);
+    CHECK(read_file(path) == "head|1-2|tail");
+
+    // write errors surface from flush
+    const int read_only = ::open(path.c_str(), O_RDONLY);
+    REQUIRE(read_only >= 0);
+    for (const bool use_pwrite : {false, true}) {
+        lrstd::uring_file_options options;
+        options.use_pwrite = use_pwrite;
+        lrstd::uring_file_sink sink(read_only, options);
+        lrstd::format_to(sink.out(), "{}", 1);
+        CHECK_THROWS_AS(sink.flush(), std::system_error);
+    }
+    ::close(read_only);
+
+    std::remove(path.c_str());
+}
@@ -49,7 +49,8 @@ struct lrstd::formatter<S, Char> {
         }
         using Biggest = std::conditional_t<std::is_signed_v<Int>, long long,
                                            unsigned long long>;
-        return i <= static_cast<Biggest>(std::numeric_limits<int>::max());
+        return static_cast<Biggest>(i) <=
+               static_cast<Biggest>(std::numeric_limits<int>::max());
     }
 
     // Formats an S with width given by the argument width_­arg_­id.